@@ -0,0 +1,539 @@
+//
+// Created by Gxin on 2024/3/28.
+//
+
+#include <gx/gsizeclass_allocator.h>
+#include <gx/gmemory_resource.h>
+#include <gx/gthread.h>
+#include <gx/gtime.h>
+
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+
+constexpr size_t OPS_PER_THREAD = 2000000;
+constexpr size_t LIVE_SLOTS = 4096;
+
+/**
+ * Every thread keeps LIVE_SLOTS allocations alive and replaces a random one at each step,
+ * sizes are mostly small with an occasional larger buffer, a part of the blocks is freed by another thread.
+ */
+template<typename AllocFunc, typename FreeFunc>
+static void churn(const char *name, size_t threadCount, AllocFunc allocFunc, FreeFunc freeFunc)
+{
+    std::vector<std::thread> threads;
+    std::vector<std::vector<void *>> leftovers(threadCount);
+
+    const GTime t0 = GTime::currentSteadyTime();
+    for (size_t t = 0; t < threadCount; t++) {
+        threads.emplace_back([&, t] {
+            std::mt19937 rng(static_cast<uint32_t>(t + 1));
+            std::uniform_int_distribution<size_t> slotDist(0, LIVE_SLOTS - 1);
+            std::uniform_int_distribution<size_t> smallSize(8, 256);
+            std::uniform_int_distribution<size_t> mediumSize(257, 8192);
+            std::uniform_int_distribution<int32_t> percent(0, 99);
+
+            std::vector<void *> slots(LIVE_SLOTS, nullptr);
+            for (size_t i = 0; i < OPS_PER_THREAD; i++) {
+                void *&slot = slots[slotDist(rng)];
+                freeFunc(slot);
+                const size_t size = percent(rng) < 90 ? smallSize(rng) : mediumSize(rng);
+                slot = allocFunc(size);
+                static_cast<char *>(slot)[0] = 1;
+            }
+            // Handed to the next thread, which frees them after the run (cross-thread free)
+            leftovers[(t + 1) % threadCount] = std::move(slots);
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    const GTime t1 = GTime::currentSteadyTime();
+
+    threads.clear();
+    for (size_t t = 0; t < threadCount; t++) {
+        threads.emplace_back([&, t] {
+            for (void *p: leftovers[t]) {
+                freeFunc(p);
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    Log("{} x{} threads: {} ns/op", name, threadCount,
+        static_cast<double>(t1.nanoSecsTo(t0)) / static_cast<double>(OPS_PER_THREAD));
+}
+
+/**
+ * Per-request scratch memory: many small allocations released all at once at the end of the request
+ */
+static void scratch()
+{
+    constexpr size_t REQUESTS = 20000;
+    constexpr size_t ALLOCS_PER_REQUEST = 256;
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<size_t> sizeDist(16, 2048);
+    std::vector<size_t> sizes(ALLOCS_PER_REQUEST);
+    for (auto &size: sizes) {
+        size = sizeDist(rng);
+    }
+
+    std::vector<void *> ptrs(ALLOCS_PER_REQUEST);
+    GTime t0 = GTime::currentSteadyTime();
+    for (size_t r = 0; r < REQUESTS; r++) {
+        for (size_t i = 0; i < ALLOCS_PER_REQUEST; i++) {
+            ptrs[i] = malloc(sizes[i]);
+            static_cast<char *>(ptrs[i])[0] = 1;
+        }
+        for (void *p: ptrs) {
+            free(p);
+        }
+    }
+    GTime t1 = GTime::currentSteadyTime();
+    Log("Scratch malloc/free: {} ns/request", t1.nanoSecsTo(t0) / (int64_t) REQUESTS);
+
+    GChainedLinearArena arena("Scratch", GNullArea(), 4096);
+    t0 = GTime::currentSteadyTime();
+    for (size_t r = 0; r < REQUESTS; r++) {
+        for (size_t i = 0; i < ALLOCS_PER_REQUEST; i++) {
+            static_cast<char *>(arena.alloc(sizes[i]))[0] = 1;
+        }
+        arena.reset();
+    }
+    t1 = GTime::currentSteadyTime();
+    Log("Scratch GChainedLinearArena: {} ns/request, steady state capacity: {} KB in {} block(s)",
+        t1.nanoSecsTo(t0) / (int64_t) REQUESTS, arena.capacity() / 1024, arena.getAllocator().blockCount());
+}
+
+/**
+ * A capped chain shrinks its last block to the room left under the cap, the spare block counts toward it
+ */
+static void cappedChain()
+{
+    constexpr size_t CAP = 10 * 1024;
+    GChainedLinearAllocator chain(4096, CAP);
+    bool ok = chain.alloc(4000) && chain.alloc(4000);
+    // The next geometric block (16 KB) exceeds the cap, the 2 KB left still serve a small request
+    ok &= chain.alloc(1024) != nullptr;
+    ok &= chain.capacity() <= CAP;
+    ok &= chain.alloc(4096) == nullptr;
+
+    chain.reset();
+    // Only the largest block (6 KB) is kept, the 4 KB left under the cap hold another block
+    ok &= chain.alloc(4000) && chain.alloc(3000);
+    ok &= chain.alloc(2048) == nullptr;
+    ok &= chain.capacity() <= CAP;
+
+    Log("Capped GChainedLinearAllocator: {}, capacity = {} KB in {} block(s)", ok, chain.capacity() / 1024, chain.blockCount());
+}
+
+/**
+ * Less than a chunk left at the end of the buffer, the small allocations still use every byte of it
+ */
+static void concurrentTail()
+{
+    alignas(GConcurrentLinearAllocator::MIN_ALIGNMENT) char buffer[1024];
+    GConcurrentLinearAllocator allocator(buffer, buffer + sizeof(buffer), 512);
+    bool ok = allocator.alloc(600) != nullptr;
+    size_t count = 0;
+    while (allocator.alloc(16)) {
+        count++;
+    }
+    // 600 rounds up to 608, the 416 bytes left hold 26 allocations
+    ok &= count == 26 && allocator.size() == sizeof(buffer);
+
+    allocator.reset();
+    ok &= allocator.alloc(16) != nullptr && allocator.size() == 512;
+
+    Log("GConcurrentLinearAllocator tail chunk: {}, small allocations after 600 bytes = {}", ok, count);
+}
+
+/**
+ * A pool grown to a million objects, walked in allocation order, then emptied
+ */
+static void poolGrowth()
+{
+    constexpr size_t OBJECT_COUNT = 1000000;
+    struct Object
+    {
+        Object *next;
+        int64_t value;
+    };
+
+    const auto walk = [](Object *head) {
+        int64_t sum = 0;
+        for (const Object *o = head; o; o = o->next) {
+            sum += o->value;
+        }
+        return sum;
+    };
+
+    std::vector<Object *> objects(OBJECT_COUNT);
+    GTime t0 = GTime::currentSteadyTime();
+    for (size_t i = 0; i < OBJECT_COUNT; i++) {
+        objects[i] = static_cast<Object *>(malloc(sizeof(Object)));
+        objects[i]->value = static_cast<int64_t>(i);
+        objects[i]->next = i ? objects[i - 1] : nullptr;
+    }
+    GTime t1 = GTime::currentSteadyTime();
+    int64_t sum = walk(objects.back());
+    GTime t2 = GTime::currentSteadyTime();
+    for (Object *o: objects) {
+        free(o);
+    }
+    Log("Pool growth malloc: alloc {} ns/object, walk {} ns/object (sum {})",
+        t1.nanoSecsTo(t0) / (int64_t) OBJECT_COUNT, static_cast<double>(t2.nanoSecsTo(t1)) / OBJECT_COUNT, sum);
+
+    for (const size_t slabSize: {size_t(4096), size_t(64 * 1024)}) {
+        GArena<ObjectPoolAllocator<Object>, GLockingPolicy::NoLock> pool("Pool", 0, slabSize, 4);
+        t0 = GTime::currentSteadyTime();
+        for (size_t i = 0; i < OBJECT_COUNT; i++) {
+            objects[i] = static_cast<Object *>(pool.alloc(sizeof(Object), alignof(Object)));
+            objects[i]->value = static_cast<int64_t>(i);
+            objects[i]->next = i ? objects[i - 1] : nullptr;
+        }
+        t1 = GTime::currentSteadyTime();
+        sum = walk(objects.back());
+        t2 = GTime::currentSteadyTime();
+        const size_t slabs = pool.getAllocator().slabCount();
+        for (Object *o: objects) {
+            pool.free(o);
+        }
+        const GTime t3 = GTime::currentSteadyTime();
+        Log("Pool growth {} KB slabs: alloc {} ns/object, walk {} ns/object (sum {}), free {} ns/object, {} slabs, capacity after free {} KB",
+            slabSize / 1024, t1.nanoSecsTo(t0) / (int64_t) OBJECT_COUNT, static_cast<double>(t2.nanoSecsTo(t1)) / OBJECT_COUNT,
+            sum, t3.nanoSecsTo(t2) / (int64_t) OBJECT_COUNT, slabs, pool.capacity() / 1024);
+    }
+}
+
+/**
+ * Several workers filling one shared linear arena with small allocations, then the arena is reset
+ */
+template<typename Arena>
+static void sharedLinear(const char *name, size_t threadCount, Arena &arena)
+{
+    constexpr size_t ROUNDS = 20;
+    constexpr size_t ALLOCS_PER_ROUND = 50000;
+
+    std::atomic<size_t> failed{0};
+    const GTime t0 = GTime::currentSteadyTime();
+    for (size_t r = 0; r < ROUNDS; r++) {
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < threadCount; t++) {
+            threads.emplace_back([&, t] {
+                for (size_t i = 0; i < ALLOCS_PER_ROUND; i++) {
+                    auto *p = static_cast<char *>(arena.alloc(16 + (i + t) % 8 * 8));
+                    if (!p) {
+                        failed.fetch_add(1, std::memory_order_relaxed);
+                        continue;
+                    }
+                    p[0] = 1;
+                }
+            });
+        }
+        for (auto &thread: threads) {
+            thread.join();
+        }
+        // Quiescent point, every worker has joined
+        arena.reset();
+    }
+    const GTime t1 = GTime::currentSteadyTime();
+
+    Log("{} x{} threads: {} ns/alloc, failed = {}", name, threadCount,
+        static_cast<double>(t1.nanoSecsTo(t0)) / static_cast<double>(ROUNDS * ALLOCS_PER_ROUND * threadCount),
+        failed.load());
+}
+
+static void sharedLinearScaling(size_t maxThreads)
+{
+    const size_t areaSize = 8 * 1024 * 1024 * maxThreads;
+    for (size_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+        GArena<GLinearAllocator, GLockingPolicy::Mutex> mutexArena("Mutex", areaSize);
+        sharedLinear("GLinearAllocator + Mutex", threadCount, mutexArena);
+
+        GArena<GLinearAllocator, GLockingPolicy::SpinLock> spinArena("SpinLock", areaSize);
+        sharedLinear("GLinearAllocator + SpinLock", threadCount, spinArena);
+
+        GArena<GLinearAllocator, GLockingPolicy::Adaptive> adaptiveArena("Adaptive", areaSize);
+        sharedLinear("GLinearAllocator + Adaptive", threadCount, adaptiveArena);
+
+        GConcurrentLinearArena atomicArena("Atomic", areaSize);
+        sharedLinear("GConcurrentLinearAllocator", threadCount, atomicArena);
+
+        GConcurrentLinearArena chunkArena("Chunked", areaSize, 64 * 1024);
+        sharedLinear("GConcurrentLinearAllocator 64KB chunks", threadCount, chunkArena);
+    }
+}
+
+/**
+ * A request building a few std::pmr containers from the given resource, then dropping them
+ */
+static size_t pmrRequest(std::pmr::memory_resource *resource)
+{
+    std::pmr::vector<int32_t> values(resource);
+    std::pmr::unordered_map<int32_t, std::pmr::string> names(resource);
+    for (int32_t i = 0; i < 200; i++) {
+        values.push_back(i);
+        names.emplace(i, std::pmr::string("a name longer than the small string buffer", resource));
+    }
+    return values.size() + names.size();
+}
+
+static void pmrResources()
+{
+    constexpr size_t REQUESTS = 5000;
+
+    const auto measure = [&](const char *name, std::pmr::memory_resource *resource, auto &&afterRequest) {
+        size_t total = 0;
+        const GTime t0 = GTime::currentSteadyTime();
+        for (size_t r = 0; r < REQUESTS; r++) {
+            total += pmrRequest(resource);
+            afterRequest();
+        }
+        const GTime t1 = GTime::currentSteadyTime();
+        Log("pmr {}: {} ns/request ({})", name, t1.nanoSecsTo(t0) / (int64_t) REQUESTS, total);
+    };
+
+    measure("default resource", std::pmr::get_default_resource(), [] {});
+
+    GSizeClassArena sizeClassArena("pmr SizeClass");
+    GArenaMemoryResource sizeClassResource(sizeClassArena);
+    measure("GArenaMemoryResource<GSizeClassArena>", &sizeClassResource, [] {});
+
+    std::pmr::monotonic_buffer_resource monotonic(256 * 1024);
+    measure("monotonic_buffer_resource", &monotonic, [&] { monotonic.release(); });
+
+    GFrameMemoryResource frame(256 * 1024);
+    size_t frameUsed = 0;
+    measure("GFrameMemoryResource", &frame, [&] {
+        frameUsed = frame.size();
+        frame.reset();
+    });
+    Log("GFrameMemoryResource: {} KB used per request, {} overflows", frameUsed / 1024, frame.overflowCount());
+}
+
+/**
+ * Creating and dropping smart pointers, the arena ones make a single allocation
+ */
+static void smartPointers()
+{
+    constexpr size_t COUNT = 1000000;
+    struct Payload
+    {
+        int64_t values[4];
+    };
+    static_assert(sizeof(GArenaUniquePtr<Payload, GSizeClassArena>) == 2 * sizeof(void *));
+
+    GSizeClassArena arena("Smart pointers");
+    std::vector<std::shared_ptr<Payload>> shared(COUNT);
+
+    GTime t0 = GTime::currentSteadyTime();
+    for (auto &p: shared) {
+        p = std::make_shared<Payload>();
+    }
+    shared.assign(COUNT, nullptr);
+    GTime t1 = GTime::currentSteadyTime();
+    Log("std::make_shared: {} ns/object", t1.nanoSecsTo(t0) / (int64_t) COUNT);
+
+    t0 = GTime::currentSteadyTime();
+    for (auto &p: shared) {
+        p = arena.makeShared<Payload>();
+    }
+    shared.assign(COUNT, nullptr);
+    t1 = GTime::currentSteadyTime();
+    Log("GArena::makeShared: {} ns/object", t1.nanoSecsTo(t0) / (int64_t) COUNT);
+
+    std::vector<GArenaUniquePtr<Payload, GSizeClassArena>> unique(COUNT);
+    t0 = GTime::currentSteadyTime();
+    for (auto &p: unique) {
+        p = arena.makeUnique<Payload>();
+    }
+    unique.clear();
+    t1 = GTime::currentSteadyTime();
+    Log("GArena::makeUnique: {} ns/object, {} bytes per pointer", t1.nanoSecsTo(t0) / (int64_t) COUNT,
+        sizeof(GArenaUniquePtr<Payload, GSizeClassArena>));
+}
+
+/**
+ * A pool arena only serves its element size, makeShared keeps the control block out of it
+ */
+static void poolSmartPointers()
+{
+    struct Payload
+    {
+        int64_t values[5];
+    };
+    GArena<ObjectPoolAllocator<Payload>, GLockingPolicy::NoLock> arena("Pool smart pointers");
+
+    std::vector<std::shared_ptr<Payload>> shared;
+    for (int64_t i = 0; i < 1000; i++) {
+        shared.push_back(arena.makeShared<Payload>(Payload{{i, i, i, i, i}}));
+    }
+    bool ok = true;
+    for (int64_t i = 0; i < 1000; i++) {
+        ok &= shared[i]->values[0] == i && shared[i]->values[4] == i;
+    }
+    shared.clear();
+
+    // Still stored the way callers did before GArenaUniquePtr
+    GUniquePtr<Payload> unique = arena.makeUnique<Payload>(Payload{{7, 7, 7, 7, 7}});
+    ok &= unique->values[4] == 7;
+    unique.reset();
+
+    Log("Pool arena makeShared/makeUnique: {}, pool size after release = {}", ok, arena.size());
+}
+
+/**
+ * A large scratch arena filled once, the first pass over fresh memory pays the page faults
+ */
+template<typename Arena>
+static void firstTouch(const char *name, Arena &arena)
+{
+    constexpr size_t CHUNK_SIZE = 4096;
+
+    const GTime t0 = GTime::currentSteadyTime();
+    size_t chunks = 0;
+    while (auto *p = static_cast<char *>(arena.alloc(CHUNK_SIZE))) {
+        memset(p, 1, CHUNK_SIZE);
+        ++chunks;
+    }
+    const GTime t1 = GTime::currentSteadyTime();
+    Log("{}: filled {} MB, {} ns per 4 KB chunk",
+        name, chunks * CHUNK_SIZE / (1024 * 1024), t1.nanoSecsTo(t0) / static_cast<int64_t>(std::max<size_t>(chunks, 1)));
+}
+
+static void mmapAreas()
+{
+    constexpr size_t AREA_SIZE = 256 * 1024 * 1024;
+    using MmapLinearArena = GArena<GLinearAllocator, GLockingPolicy::NoLock, GMmapArea>;
+
+    GArena<GLinearAllocator, GLockingPolicy::NoLock> heapArena("Heap area", AREA_SIZE);
+    firstTouch("GHeapArea", heapArena);
+
+    MmapLinearArena mmapArena("Mmap area", AREA_SIZE);
+    firstTouch("GMmapArea", mmapArena);
+
+    GMmapArea::Options options;
+    options.hugePages = GMmapArea::HugePages::Transparent;
+    MmapLinearArena thpArena("THP area", GMmapArea(AREA_SIZE, options));
+    firstTouch(thpArena.getArea().isHugePages() ? "GMmapArea transparent huge pages" : "GMmapArea (no THP)", thpArena);
+
+    options.hugePages = GMmapArea::HugePages::Explicit;
+    MmapLinearArena hugeArena("Huge page area", GMmapArea(AREA_SIZE, options));
+    firstTouch("GMmapArea explicit huge pages (or fallback)", hugeArena);
+
+    options.hugePages = GMmapArea::HugePages::None;
+    options.populate = true;
+    const GTime t0 = GTime::currentSteadyTime();
+    MmapLinearArena populatedArena("Populated area", GMmapArea(AREA_SIZE, options));
+    const GTime t1 = GTime::currentSteadyTime();
+    Log("GMmapArea populate at construction: {} ms", t1.milliSecsTo(t0));
+    firstTouch("GMmapArea populated", populatedArena);
+}
+
+/**
+ * Tracked arenas show up in GArenaRegistry, untracked ones cost no room nor time
+ */
+static void tracking()
+{
+    using TrackedHeapArena = GArena<GHeapAllocator, GLockingPolicy::NoLock, GHeapArea, GTrackingPolicy::Counters>;
+    using TrackedLinearArena = GArena<GLinearAllocator, GLockingPolicy::NoLock, GHeapArea, GTrackingPolicy::Full>;
+    static_assert(sizeof(GHeapArena) == sizeof(GArena<GHeapAllocator, GLockingPolicy::NoLock, GHeapArea>));
+
+    TrackedHeapArena heapArena("Tracked heap");
+    std::vector<void *> blocks;
+    for (size_t i = 1; i <= 100; i++) {
+        blocks.push_back(heapArena.alloc(i * 16));
+    }
+    for (size_t i = 0; i < 50; i++) {
+        heapArena.free(blocks[i], (i + 1) * 16);
+    }
+
+    TrackedLinearArena linearArena("Tracked linear", 4096);
+    linearArena.alloc(1024);
+    void *const marker = linearArena.getCurrent();
+    linearArena.alloc(1024);
+    linearArena.alloc(1024);
+    linearArena.rewind(marker);
+    linearArena.alloc(8192);
+
+    // The chained blocks are not address ordered, the rewind must still drop exactly what followed the marker
+    using TrackedChainedArena = GArena<GChainedLinearAllocator, GLockingPolicy::NoLock, GNullArea, GTrackingPolicy::Full>;
+    TrackedChainedArena chainedArena("Tracked chained", GNullArea(), size_t(1024));
+    std::vector<void *> chained;
+    for (size_t i = 0; i < 4; i++) {
+        chained.push_back(chainedArena.alloc(512));
+    }
+    void *const chainedMarker = chainedArena.getCurrent();
+    for (size_t i = 0; i < 16; i++) {
+        chainedArena.alloc(512);
+    }
+    chainedArena.rewind(chainedMarker);
+    const bool exact = chainedArena.stats().currentBytes == 4 * 512;
+    for (void *p: chained) {
+        chainedArena.free(p);
+    }
+    Log("Full tracking rewind across chained blocks: {}", exact);
+
+    GArenaRegistry::dump();
+
+    for (size_t i = 50; i < blocks.size(); i++) {
+        heapArena.free(blocks[i], (i + 1) * 16);
+    }
+    linearArena.reset();
+}
+
+int main(int argc, char *argv[])
+{
+    tracking();
+    mmapAreas();
+    pmrResources();
+    smartPointers();
+    poolSmartPointers();
+
+    scratch();
+    cappedChain();
+    concurrentTail();
+    poolGrowth();
+
+    const size_t maxThreads = std::max<size_t>(GThread::hardwareConcurrency(), 4);
+
+    sharedLinearScaling(maxThreads);
+
+    for (size_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+        churn("malloc", threadCount,
+              [](size_t size) { return malloc(size); },
+              [](void *p) { free(p); });
+
+        GHeapArena heapArena("Heap");
+        churn("GHeapAllocator", threadCount,
+              [&](size_t size) { return heapArena.alloc(size); },
+              [&](void *p) { heapArena.free(p); });
+
+        GSizeClassArena sizeClassArena("SizeClass");
+        churn("GSizeClassAllocator", threadCount,
+              [&](size_t size) { return sizeClassArena.alloc(size); },
+              [&](void *p) { sizeClassArena.free(p); });
+    }
+
+    const auto stats = GSizeClassAllocator::stats();
+    Log("GSizeClassAllocator reserved: {} KB, depot: {} KB, large allocations: {}",
+        stats.reservedBytes / 1024, stats.depotBytes / 1024, stats.largeAllocs);
+
+    // STL containers through the arena
+    GSizeClassArena arena("Vector");
+    std::vector<int, GSTLAllocator<int, GSizeClassArena>> values{GSTLAllocator<int, GSizeClassArena>(arena)};
+    for (int i = 0; i < 100000; i++) {
+        values.push_back(i);
+    }
+    Log("STL vector through GSizeClassArena: {} elements, back = {}", values.size(), values.back());
+
+    return EXIT_SUCCESS;
+}
@@ -13,6 +13,7 @@
 #include <gx/debug.h>
 
 #include <cstring>
+#include <thread>
 
 
 struct Info
@@ -256,7 +257,254 @@ bool testCopyOnWrite()
     ba.seekWritePos(SEEK_SET, 0);
     ba.write(456);
 
-    return ba != bb && bb == bc;
+    if (!(ba != bb && bb == bc)) {
+        return false;
+    }
+
+    // Only the written bytes of a large reserved buffer are copied, the copy keeps them
+    GByteArray big;
+    big.reserve(64 * 1024 * 1024);
+    big.write(static_cast<int32_t>(1));
+    GByteArray bigCopy = big;
+    bigCopy.write(static_cast<int32_t>(2));
+    int32_t first = 0, second = 0;
+    bigCopy >> first >> second;
+    if (first != 1 || second != 2 || big.size() != 4) {
+        return false;
+    }
+
+    // A shared buffer grown by a write
+    GByteArray small;
+    small.write(static_cast<int32_t>(3));
+    GByteArray grown = small;
+    const std::string text(1000, 'x');
+    grown.write(text);
+    int32_t value = 0;
+    std::string read;
+    grown >> value >> read;
+    return value == 3 && read == text && small.size() == 4 && small.data() != grown.data();
+}
+
+bool testSlice()
+{
+    // Framed message: count, then length prefixed payloads
+    GByteArray frame;
+    frame.write(static_cast<int32_t>(3));
+    for (int32_t i = 0; i < 3; i++) {
+        GByteArray payload;
+        payload << i << std::string("payload");
+        frame << payload;
+    }
+
+    int32_t count;
+    frame >> count;
+    std::vector<GByteArray> payloads(count);
+    for (auto &payload: payloads) {
+        frame >> payload;
+        // Shared, no copy
+        if (payload.data() < frame.data() || payload.data() + payload.size() > frame.data() + frame.size()) {
+            return false;
+        }
+    }
+    for (int32_t i = 0; i < count; i++) {
+        int32_t index;
+        std::string text;
+        payloads[i] >> index >> text;
+        if (index != i || text != "payload") {
+            return false;
+        }
+    }
+
+    // Writing promotes the slice, the frame is left untouched
+    const GByteArray before = frame.slice(0);
+    GByteArray &first = payloads[0];
+    first.seekWritePos(SEEK_SET, 0);
+    first.write(static_cast<int32_t>(42));
+    int32_t index;
+    first.seekReadPos(SEEK_SET, 0);
+    first >> index;
+    if (index != 42 || first.size() != sizeof(int32_t) || frame != before) {
+        return false;
+    }
+
+    const GByteArray middle = frame.slice(4, 8);
+    GByteArray rest = frame;
+    rest.seekReadPos(SEEK_SET, 4);
+    const GByteArray read = rest.readSlice(8);
+    return middle == read && middle.data() == frame.data() + 4 && rest.readPos() == 12
+           && frame.slice(frame.size() + 10).isEmpty();
+}
+
+bool testSliceRange()
+{
+    GByteArray big;
+    big.reserve(64 * 1024 * 1024);
+    big.seekWritePos(SEEK_END, 0);
+
+    // Promoted with its range only, wherever it starts
+    for (const int64_t pos: {0, 8}) {
+        GByteArray slice = big.slice(pos, 16);
+        slice.seekWritePos(SEEK_SET, 0);
+        slice.write(static_cast<int32_t>(1));
+        if (slice.capacity() != 16 || big.data()[pos] != 0) {
+            return false;
+        }
+    }
+
+    // Never grows over the bytes after its range
+    GByteArray payload;
+    payload << std::string("0123456789abcdef");
+    GByteArray slice = payload.slice(4, 4);
+    slice.seekWritePos(SEEK_END, 0);
+    return slice.size() == 4 && slice.capacity() == 4;
+}
+
+bool testSliceByteOrder()
+{
+    GByteArray payload;
+    payload.write(static_cast<uint32_t>(0x01020304));
+
+    GByteArray ba;
+    ba.setByteOrder(GByteArray::BigEndian);
+    ba << payload;
+
+    GByteArray out;
+    ba >> out;
+    uint32_t value;
+    out >> value;
+    return value == 0x01020304;
+}
+
+bool testSeekZeroes()
+{
+    GByteArray ba(4096);
+    ba.seekWritePos(SEEK_END, 0);
+    for (int64_t i = 0; i < ba.size(); i++) {
+        if (ba.data()[i] != 0) {
+            return false;
+        }
+    }
+
+    // Written bytes are kept, only the never written ones are zeroed
+    GByteArray bb;
+    bb.write(static_cast<int64_t>(-1));
+    bb.reserve(64);
+    bb.seekWritePos(SEEK_SET, 32);
+    int64_t value, zero[3];
+    bb >> value;
+    bb.read(zero, sizeof(zero));
+    return value == -1 && zero[0] == 0 && zero[1] == 0 && zero[2] == 0;
+}
+
+bool testAdopt()
+{
+    int releases = 0;
+    auto *region = static_cast<uint8_t *>(malloc(16));
+    memset(region, 7, 16);
+    GByteArray slice;
+    {
+        GByteArray ba(region, 16, [&](uint8_t *data, int64_t size) {
+            releases += data == region && size == 16;
+            free(data);
+        });
+        if (ba.data() != region || ba.size() != 16) {
+            return false;
+        }
+
+        // Written in place, then kept alive by slices
+        ba.seekWritePos(SEEK_SET, 0);
+        ba.write(static_cast<uint32_t>(1));
+        ba.seekWritePos(SEEK_SET, 16);
+        if (ba.data() != region || *reinterpret_cast<uint32_t *>(region) != 1) {
+            return false;
+        }
+        slice = ba.slice(8, 4);
+    }
+    if (slice.data() != region + 8 || releases != 0) {
+        return false;
+    }
+    slice = GByteArray();
+    if (releases != 1) {
+        return false;
+    }
+
+    // Growing hands the region back before the array goes away
+    region = static_cast<uint8_t *>(malloc(4));
+    memset(region, 1, 4);
+    GByteArray grown(region, 4, [&](uint8_t *data, int64_t) {
+        releases++;
+        free(data);
+    });
+    grown.write(static_cast<uint32_t>(2));
+    uint32_t first, second;
+    grown >> first >> second;
+    if (releases != 2 || first != 0x01010101 || second != 2) {
+        return false;
+    }
+
+    std::vector<uint8_t> vector(32, 3);
+    const uint8_t *storage = vector.data();
+    GByteArray fromVector(std::move(vector));
+    return fromVector.data() == storage && fromVector.size() == 32;
+}
+
+bool testBorrow()
+{
+    const uint8_t bytes[] = {1, 2, 3, 4, 5, 6, 7, 8};
+    GByteArray ba = GByteArray::borrow(bytes, sizeof(bytes));
+    if (ba.data() != bytes || ba.size() != sizeof(bytes) || GByteArray::md5Sum(ba) != GByteArray::md5Sum(GByteArray(bytes, sizeof(bytes)))) {
+        return false;
+    }
+
+    // Never written, even without other owners
+    ba.seekWritePos(SEEK_SET, 0);
+    ba.write(static_cast<uint8_t>(9));
+    return ba.data() != bytes && ba.data()[0] == 9 && bytes[0] == 1;
+}
+
+bool testCursors()
+{
+    // The count is patched in once the records are written
+    GByteArray frame;
+    GByteWriter writer(frame);
+    writer << static_cast<int32_t>(0);
+    for (int32_t i = 0; i < 1000; i++) {
+        writer << i << std::string("record");
+    }
+    GByteWriter(frame, 0).write(static_cast<int32_t>(1000));
+    if (writer.pos() != frame.size()) {
+        return false;
+    }
+
+    // Decoders share the frame, each with its own cursor
+    const GByteArray &shared = frame;
+    std::vector<int64_t> sums(4, 0);
+    std::vector<std::thread> decoders;
+    for (size_t t = 0; t < sums.size(); t++) {
+        decoders.emplace_back([&shared, &sum = sums[t]] {
+            GByteReader reader(shared);
+            int32_t count;
+            reader >> count;
+            for (int32_t i = 0; i < count; i++) {
+                int32_t index;
+                std::string text;
+                reader >> index >> text;
+                sum += text == "record" ? index : -1;
+            }
+            if (reader.canReadMore()) {
+                sum = -1;
+            }
+        });
+    }
+    for (auto &decoder: decoders) {
+        decoder.join();
+    }
+    for (const int64_t sum: sums) {
+        if (sum != 999 * 1000 / 2) {
+            return false;
+        }
+    }
+    return shared.readPos() == 0;
 }
 
 int main(int argc, char *argv[])
@@ -277,6 +525,13 @@ int main(int argc, char *argv[])
     Log("Test sha256Sum: {}", testSha256Sum() ? "OK" : "FAIL");
     Log("Test byte order: {}", testByteOrder() ? "OK" : "FAIL");
     Log("Test copy on write: {}", testCopyOnWrite() ? "OK" : "FAIL");
+    Log("Test slice: {}", testSlice() ? "OK" : "FAIL");
+    Log("Test slice range: {}", testSliceRange() ? "OK" : "FAIL");
+    Log("Test slice byte order: {}", testSliceByteOrder() ? "OK" : "FAIL");
+    Log("Test seek zeroes: {}", testSeekZeroes() ? "OK" : "FAIL");
+    Log("Test adopt: {}", testAdopt() ? "OK" : "FAIL");
+    Log("Test borrow: {}", testBorrow() ? "OK" : "FAIL");
+    Log("Test cursors: {}", testCursors() ? "OK" : "FAIL");
 
     return EXIT_SUCCESS;
 }
\ No newline at end of file
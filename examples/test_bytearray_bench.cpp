@@ -0,0 +1,244 @@
+//
+// Created by Gxin on 2024/4/4.
+//
+
+#include <gx/gbytearray.h>
+#include <gx/gtime.h>
+#include <gx/debug.h>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+
+constexpr int64_t KB = 1024;
+constexpr int64_t MB = 1024 * KB;
+constexpr int64_t GB = 1024 * MB;
+
+/**
+ * Repeats small streams until about MIN_TOTAL bytes are written, so every size is timed over a similar amount of work
+ */
+constexpr int64_t MIN_TOTAL = 256 * MB;
+
+static double mbPerSec(int64_t bytes, int64_t ns)
+{
+    return static_cast<double>(bytes) / static_cast<double>(MB) / (static_cast<double>(ns) / 1e9);
+}
+
+static void append(int64_t streamSize, int64_t chunkSize, bool reserve)
+{
+    std::vector<uint8_t> chunk(chunkSize, 0x5a);
+    const int64_t repeat = std::max<int64_t>(1, MIN_TOTAL / streamSize);
+
+    int64_t checksum = 0;
+    const GTime t0 = GTime::currentSteadyTime();
+    for (int64_t r = 0; r < repeat; r++) {
+        GByteArray ba;
+        if (reserve) {
+            ba.reserve(streamSize);
+        }
+        for (int64_t written = 0; written < streamSize; written += chunkSize) {
+            ba.write(chunk.data(), std::min(chunkSize, streamSize - written));
+        }
+        checksum += ba.size();
+    }
+    const GTime t1 = GTime::currentSteadyTime();
+
+    Log("GByteArray append {} KB stream in {} byte chunks{}: {} MB/s ({})",
+        streamSize / KB, chunkSize, reserve ? ", reserved" : "",
+        mbPerSec(streamSize * repeat, t1.nanoSecsTo(t0)), checksum == streamSize * repeat);
+}
+
+static void appendVector(int64_t streamSize, int64_t chunkSize)
+{
+    std::vector<uint8_t> chunk(chunkSize, 0x5a);
+    const int64_t repeat = std::max<int64_t>(1, MIN_TOTAL / streamSize);
+
+    int64_t checksum = 0;
+    const GTime t0 = GTime::currentSteadyTime();
+    for (int64_t r = 0; r < repeat; r++) {
+        std::vector<uint8_t> v;
+        for (int64_t written = 0; written < streamSize; written += chunkSize) {
+            const int64_t n = std::min(chunkSize, streamSize - written);
+            v.insert(v.end(), chunk.data(), chunk.data() + n);
+        }
+        checksum += static_cast<int64_t>(v.size());
+    }
+    const GTime t1 = GTime::currentSteadyTime();
+
+    Log("std::vector append {} KB stream in {} byte chunks: {} MB/s ({})",
+        streamSize / KB, chunkSize,
+        mbPerSec(streamSize * repeat, t1.nanoSecsTo(t0)), checksum == streamSize * repeat);
+}
+
+static void smallWrites(int64_t streamSize)
+{
+    const int64_t repeat = std::max<int64_t>(1, MIN_TOTAL / 4 / streamSize);
+
+    const GTime t0 = GTime::currentSteadyTime();
+    for (int64_t r = 0; r < repeat; r++) {
+        GByteArray ba;
+        for (int64_t i = 0; i < streamSize / 8; i++) {
+            ba.write(i);
+        }
+    }
+    const GTime t1 = GTime::currentSteadyTime();
+
+    Log("GByteArray write(int64_t) {} KB stream: {} MB/s",
+        streamSize / KB, mbPerSec(streamSize * repeat, t1.nanoSecsTo(t0)));
+}
+
+/**
+ * A frame of length prefixed sub-messages, split into GByteArray slices or copied out into vectors
+ */
+static void framedParse(int64_t payloadSize)
+{
+    const int64_t count = std::max<int64_t>(1, 64 * MB / payloadSize);
+    GByteArray frame;
+    frame.reserve(count * (payloadSize + 8));
+    const std::vector<uint8_t> payload(payloadSize, 0x5a);
+    for (int64_t i = 0; i < count; i++) {
+        frame.write(payload);
+    }
+
+    int64_t total = 0;
+    GTime t0 = GTime::currentSteadyTime();
+    for (int64_t i = 0; i < count; i++) {
+        GByteArray message;
+        frame >> message;
+        total += message.size();
+    }
+    GTime t1 = GTime::currentSteadyTime();
+    const int64_t sliceNs = t1.nanoSecsTo(t0);
+
+    frame.seekReadPos(SEEK_SET, 0);
+    t0 = GTime::currentSteadyTime();
+    for (int64_t i = 0; i < count; i++) {
+        std::vector<uint8_t> message;
+        frame.read(message);
+        total += static_cast<int64_t>(message.size());
+    }
+    t1 = GTime::currentSteadyTime();
+    const int64_t copyNs = t1.nanoSecsTo(t0);
+
+    Log("Split {} messages of {} bytes: slices {} ns/message, copies {} ns/message ({})",
+        count, payloadSize, sliceNs / count, copyNs / count, total == count * payloadSize * 2);
+}
+
+/**
+ * External data, such as a receive buffer or an mmap'd file, wrapped by copy or borrowed, then its header parsed
+ */
+static void wrapExternal(int64_t regionSize)
+{
+    const int64_t repeat = std::max<int64_t>(1, MIN_TOTAL / regionSize);
+    std::vector<uint8_t> region(regionSize, 0x5a);
+
+    int64_t checksum = 0;
+    GTime t0 = GTime::currentSteadyTime();
+    for (int64_t r = 0; r < repeat; r++) {
+        const GByteArray ba(region.data(), regionSize);
+        int64_t header;
+        ba >> header;
+        checksum += header;
+    }
+    GTime t1 = GTime::currentSteadyTime();
+    const int64_t copyNs = t1.nanoSecsTo(t0);
+
+    t0 = GTime::currentSteadyTime();
+    for (int64_t r = 0; r < repeat; r++) {
+        const GByteArray ba = GByteArray::borrow(region.data(), regionSize);
+        int64_t header;
+        ba >> header;
+        checksum -= header;
+    }
+    t1 = GTime::currentSteadyTime();
+    const int64_t borrowNs = t1.nanoSecsTo(t0);
+
+    Log("Wrap a {} KB external region: copy {} ns, borrow {} ns ({})",
+        regionSize / KB, copyNs / repeat, borrowNs / repeat, checksum == 0);
+}
+
+/**
+ * Decoders parsing one frame, sharing it through GByteReader cursors or each copying it first
+ */
+static void parallelDecode(size_t threadCount)
+{
+    constexpr int32_t RECORDS = 1000000;
+    GByteArray frame;
+    for (int32_t i = 0; i < RECORDS; i++) {
+        frame << i << static_cast<double>(i);
+    }
+
+    auto decode = [](GByteReader &reader) {
+        int64_t sum = 0;
+        while (reader.canReadMore()) {
+            int32_t index;
+            double value;
+            reader >> index >> value;
+            sum += index;
+        }
+        return sum;
+    };
+    std::vector<int64_t> sums(threadCount * 2);
+
+    GTime t0 = GTime::currentSteadyTime();
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < threadCount; t++) {
+        threads.emplace_back([&, t] {
+            GByteReader reader(frame);
+            sums[t] = decode(reader);
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    GTime t1 = GTime::currentSteadyTime();
+    const int64_t sharedNs = t1.nanoSecsTo(t0);
+
+    threads.clear();
+    t0 = GTime::currentSteadyTime();
+    for (size_t t = 0; t < threadCount; t++) {
+        threads.emplace_back([&, t] {
+            const GByteArray copy(frame.data(), frame.size());
+            GByteReader reader(copy);
+            sums[threadCount + t] = decode(reader);
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    t1 = GTime::currentSteadyTime();
+    const int64_t copyNs = t1.nanoSecsTo(t0);
+
+    bool ok = true;
+    for (const int64_t sum: sums) {
+        ok &= sum == static_cast<int64_t>(RECORDS - 1) * RECORDS / 2;
+    }
+    Log("{} decoders over a {} KB frame: shared {} ms, copied {} ms ({})",
+        threadCount, frame.size() / KB, sharedNs / 1000000, copyNs / 1000000, ok);
+}
+
+int main(int argc, char *argv[])
+{
+    const int64_t sizes[] = {1 * KB, 64 * KB, 1 * MB, 64 * MB, 1 * GB};
+
+    for (const int64_t size: sizes) {
+        append(size, 4 * KB, false);
+        append(size, 4 * KB, true);
+        appendVector(size, 4 * KB);
+    }
+    for (const int64_t size: {1 * KB, 1 * MB, 64 * MB}) {
+        smallWrites(size);
+    }
+    for (const int64_t size: {int64_t(64), 4 * KB, 256 * KB}) {
+        framedParse(size);
+    }
+    for (const int64_t size: {4 * KB, 1 * MB, 64 * MB}) {
+        wrapExternal(size);
+    }
+    for (const size_t threads: {1, 4}) {
+        parallelDecode(threads);
+    }
+
+    return EXIT_SUCCESS;
+}
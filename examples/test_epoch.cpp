@@ -0,0 +1,340 @@
+//
+// Created by Gxin on 2024/4/3.
+//
+
+#include <gx/gepoch.h>
+#include <gx/gseqlock.h>
+#include <gx/gtime.h>
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+
+/**
+ * Read-mostly map, readers look up a published snapshot without taking any lock,
+ * writers copy the snapshot, publish the new one and retire the old one.
+ */
+template<typename K, typename V>
+class ReadMostlyMap
+{
+    using Map = std::unordered_map<K, V>;
+
+public:
+    explicit ReadMostlyMap(GEpochDomain &domain)
+            : mDomain(domain),
+              mSnapshot(new Map())
+    {}
+
+    ~ReadMostlyMap()
+    {
+        delete mSnapshot.load(std::memory_order_relaxed);
+    }
+
+    bool find(const K &key, V &value) const
+    {
+        auto guard = mDomain.pin();
+        const Map *map = mSnapshot.load(std::memory_order_acquire);
+        const auto it = map->find(key);
+        if (it == map->end()) {
+            return false;
+        }
+        value = it->second;
+        return true;
+    }
+
+    void insert(const K &key, const V &value)
+    {
+        GLockerGuard locker(mWriteLock);
+        const Map *old = mSnapshot.load(std::memory_order_relaxed);
+        auto *map = new Map(*old);
+        (*map)[key] = value;
+        mSnapshot.store(map, std::memory_order_release);
+        mDomain.retire(const_cast<Map *>(old));
+    }
+
+    void erase(const K &key)
+    {
+        GLockerGuard locker(mWriteLock);
+        const Map *old = mSnapshot.load(std::memory_order_relaxed);
+        auto *map = new Map(*old);
+        map->erase(key);
+        mSnapshot.store(map, std::memory_order_release);
+        mDomain.retire(const_cast<Map *>(old));
+    }
+
+private:
+    GEpochDomain &mDomain;
+    std::atomic<const Map *> mSnapshot;
+    GMutex mWriteLock;
+};
+
+
+/**
+ * Counts the live nodes, reclamation must bring it back to zero
+ */
+struct Node
+{
+    static std::atomic<int64_t> sLive;
+
+    explicit Node(int64_t v)
+            : value(v), check(~v)
+    {
+        sLive.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    ~Node()
+    {
+        // Poison, a reader still holding the node would see a broken pair
+        check = value;
+        sLive.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    int64_t value;
+    int64_t check;
+};
+
+std::atomic<int64_t> Node::sLive{0};
+
+/**
+ * Readers dereference a shared pointer that writers keep replacing and retiring
+ */
+static bool stressEpoch(size_t readerCount, size_t writerCount, int64_t writesPerWriter)
+{
+    GEpochDomain domain;
+    std::atomic<Node *> shared(new Node(0));
+    std::atomic<bool> stop(false);
+    std::atomic<int64_t> broken(0);
+    std::atomic<int64_t> reads(0);
+
+    std::vector<std::thread> threads;
+    for (size_t r = 0; r < readerCount; r++) {
+        threads.emplace_back([&] {
+            int64_t count = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                auto guard = domain.pin();
+                const Node *node = shared.load(std::memory_order_acquire);
+                if (node->check != ~node->value) {
+                    broken.fetch_add(1, std::memory_order_relaxed);
+                }
+                count++;
+            }
+            reads.fetch_add(count, std::memory_order_relaxed);
+        });
+    }
+    std::vector<std::thread> writers;
+    for (size_t w = 0; w < writerCount; w++) {
+        writers.emplace_back([&, w] {
+            for (int64_t i = 0; i < writesPerWriter; i++) {
+                Node *old = shared.exchange(new Node(i * (int64_t) writerCount + (int64_t) w), std::memory_order_acq_rel);
+                domain.retire(old);
+            }
+            domain.flush();
+        });
+    }
+    for (auto &thread: writers) {
+        thread.join();
+    }
+    stop.store(true, std::memory_order_relaxed);
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    const size_t pending = domain.flush();
+    const int64_t liveBeforeDestroy = Node::sLive.load();
+    delete shared.load();
+
+    Log("GEpochDomain {} readers, {} writers: {} reads, {} writes, broken = {}, pending after flush = {}, live nodes = {}",
+        readerCount, writerCount, reads.load(), writesPerWriter * (int64_t) writerCount, broken.load(), pending,
+        liveBeforeDestroy);
+    return broken.load() == 0 && pending == 0 && liveBeforeDestroy == 1;
+}
+
+static bool stressReadMostlyMap(size_t readerCount, int32_t writes)
+{
+    constexpr int32_t KEY_COUNT = 64;
+
+    GEpochDomain domain;
+    std::atomic<int64_t> broken(0);
+    std::atomic<bool> stop(false);
+    {
+        ReadMostlyMap<int32_t, int64_t> map(domain);
+        for (int32_t k = 0; k < KEY_COUNT; k++) {
+            map.insert(k, k);
+        }
+
+        std::vector<std::thread> readers;
+        for (size_t r = 0; r < readerCount; r++) {
+            readers.emplace_back([&, r] {
+                int32_t k = static_cast<int32_t>(r);
+                while (!stop.load(std::memory_order_relaxed)) {
+                    int64_t value;
+                    // Values only ever grow by KEY_COUNT, the key stays their remainder
+                    if (map.find(k % KEY_COUNT, value) && value % KEY_COUNT != k % KEY_COUNT) {
+                        broken.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    k++;
+                }
+            });
+        }
+        std::thread writer([&] {
+            for (int32_t i = 0; i < writes; i++) {
+                const int32_t key = i % KEY_COUNT;
+                if (i % 16 == 15) {
+                    map.erase(key);
+                } else {
+                    map.insert(key, key + (int64_t) (i + 1) * KEY_COUNT);
+                }
+            }
+        });
+        writer.join();
+        stop.store(true, std::memory_order_relaxed);
+        for (auto &thread: readers) {
+            thread.join();
+        }
+        domain.synchronize();
+    }
+
+    Log("ReadMostlyMap {} readers, {} writes: broken = {}", readerCount, writes, broken.load());
+    return broken.load() == 0;
+}
+
+struct Pose
+{
+    double position[3];
+    double checksum;
+};
+
+static bool stressSeqLock(size_t readerCount, int32_t writes)
+{
+    GSeqLock<Pose> pose(Pose{{0, 0, 0}, 0});
+    std::atomic<bool> stop(false);
+    std::atomic<int64_t> torn(0);
+    std::atomic<int64_t> reads(0);
+
+    std::vector<std::thread> readers;
+    for (size_t r = 0; r < readerCount; r++) {
+        readers.emplace_back([&] {
+            int64_t count = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                const Pose p = pose.load();
+                if (p.position[0] + p.position[1] + p.position[2] != p.checksum) {
+                    torn.fetch_add(1, std::memory_order_relaxed);
+                }
+                count++;
+            }
+            reads.fetch_add(count, std::memory_order_relaxed);
+        });
+    }
+    std::vector<std::thread> writers;
+    for (int32_t w = 0; w < 2; w++) {
+        writers.emplace_back([&, w] {
+            for (int32_t i = 0; i < writes; i++) {
+                if (i % 2) {
+                    const double v = i * 2 + w;
+                    pose.store(Pose{{v, v * 2, v * 3}, v * 6});
+                } else {
+                    pose.update([](Pose &p) {
+                        p.position[0] += 1;
+                        p.checksum += 1;
+                    });
+                }
+            }
+        });
+    }
+    for (auto &thread: writers) {
+        thread.join();
+    }
+    stop.store(true, std::memory_order_relaxed);
+    for (auto &thread: readers) {
+        thread.join();
+    }
+
+    Log("GSeqLock {} readers, 2 writers: {} reads, {} writes, torn = {}, sequence = {}",
+        readerCount, reads.load(), writes * 2, torn.load(), pose.sequence());
+    return torn.load() == 0 && pose.sequence() == static_cast<uint32_t>(writes) * 4;
+}
+
+/**
+ * An update whose function throws leaves the value as it was and the lock usable
+ */
+static bool seqLockThrowingUpdate()
+{
+    GSeqLock<Pose> pose(Pose{{1, 2, 3}, 6});
+    bool thrown = false;
+    try {
+        pose.update([](Pose &p) {
+            p.checksum = -1;
+            throw std::runtime_error("update");
+        });
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    const bool unchanged = pose.load().checksum == 6 && pose.sequence() % 2 == 0;
+    pose.store(Pose{{2, 2, 2}, 6});
+    return thrown && unchanged && pose.load().position[0] == 2;
+}
+
+static void benchSeqLock()
+{
+    constexpr int32_t READS = 10000000;
+
+    struct Config
+    {
+        int32_t values[8];
+    };
+    GSeqLock<Config> seqLock;
+    GRWLock rwLock;
+    Config config{};
+
+    int64_t sum = 0;
+    GTime t0 = GTime::currentSteadyTime();
+    for (int32_t i = 0; i < READS; i++) {
+        sum += seqLock.load().values[i & 7];
+    }
+    GTime t1 = GTime::currentSteadyTime();
+    const double seqNs = static_cast<double>(t1.nanoSecsTo(t0)) / READS;
+
+    t0 = GTime::currentSteadyTime();
+    for (int32_t i = 0; i < READS; i++) {
+        rwLock.readLock();
+        sum += config.values[i & 7];
+        rwLock.readUnlock();
+    }
+    t1 = GTime::currentSteadyTime();
+    const double rwNs = static_cast<double>(t1.nanoSecsTo(t0)) / READS;
+
+    Log("Uncontended read of 32 bytes: GSeqLock {} ns, GRWLock {} ns ({})", seqNs, rwNs, sum);
+}
+
+int main(int argc, char *argv[])
+{
+    bool ok = true;
+    ok &= stressSeqLock(4, 100000);
+    ok &= seqLockThrowingUpdate();
+    ok &= stressEpoch(4, 2, 50000);
+    ok &= stressEpoch(8, 1, 20000);
+    ok &= stressReadMostlyMap(4, 5000);
+    benchSeqLock();
+
+    // Threads used the global domain and exited, their lists are left to flush()
+    std::vector<std::thread> threads;
+    for (int32_t t = 0; t < 4; t++) {
+        threads.emplace_back([] {
+            for (int64_t i = 0; i < 100; i++) {
+                GEpochDomain::global().retire(new Node(i));
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    GEpochDomain::global().synchronize();
+    Log("Global domain after exited threads: live nodes = {}", Node::sLive.load());
+    ok &= Node::sLive.load() == 0;
+
+    Log("{}", ok ? "All passed" : "FAILED");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
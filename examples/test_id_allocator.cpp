@@ -0,0 +1,181 @@
+//
+// Created by Gxin on 2024/4/5.
+//
+
+#include <gx/gidallocator.h>
+#include <gx/debug.h>
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+
+
+/**
+ * Allocates every ID, memory must follow the ID range, the last segment included
+ */
+template<typename ID_TYPE, ID_TYPE MaxNum>
+static bool exhaust(const char *name, uint64_t expectedCount)
+{
+    GIDAllocator<ID_TYPE, MaxNum> allocator;
+    uint64_t count = 0;
+    while (allocator.alloc() != 0) {
+        count++;
+    }
+    // Each ID holds a state and a free list link of 32 bits
+    const size_t limit = (count + 1) * 2 * sizeof(uint32_t);
+    const size_t usage = allocator.memoryUsage();
+
+    Log("{}: {} IDs, {} bytes (limit {})", name, count, usage, limit);
+    return count == expectedCount && usage <= limit;
+}
+
+/**
+ * Threads allocate and free IDs through every path, an ID must never be handed to two owners at once
+ */
+static bool stress(size_t threadCount, int32_t rounds)
+{
+    constexpr uint32_t MAX_ID = 1 << 16;
+    using Allocator = GIDAllocator<uint32_t, MAX_ID>;
+
+    Allocator allocator;
+    std::vector<std::atomic<uint8_t>> owned(MAX_ID);
+    std::atomic<int64_t> duplicates(0);
+    std::atomic<int64_t> stale(0);
+
+    auto claim = [&](uint32_t id) {
+        if (id == 0 || owned[id].exchange(1, std::memory_order_relaxed) != 0) {
+            duplicates.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (!allocator.isValid(id, allocator.generation(id))) {
+            stale.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+    // Ownership goes before the ID returns to the allocator, another thread may take it right away
+    auto release = [&](uint32_t id) {
+        owned[id].store(0, std::memory_order_relaxed);
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < threadCount; t++) {
+        threads.emplace_back([&, t] {
+            std::mt19937 random(static_cast<uint32_t>(t));
+            Allocator::LocalCache cache(allocator, 32);
+            std::vector<uint32_t> held;
+            for (int32_t r = 0; r < rounds; r++) {
+                switch (random() % 3) {
+                    case 0: {
+                        const uint32_t id = allocator.alloc();
+                        claim(id);
+                        held.push_back(id);
+                        break;
+                    }
+                    case 1: {
+                        const uint32_t id = cache.alloc();
+                        claim(id);
+                        held.push_back(id);
+                        break;
+                    }
+                    default: {
+                        uint32_t ids[16];
+                        const size_t n = allocator.allocBulk(ids, 16);
+                        for (size_t i = 0; i < n; i++) {
+                            claim(ids[i]);
+                            held.push_back(ids[i]);
+                        }
+                        break;
+                    }
+                }
+                if (held.size() < 256) {
+                    continue;
+                }
+                std::shuffle(held.begin(), held.end(), random);
+                for (const uint32_t id: held) {
+                    release(id);
+                }
+                switch (random() % 3) {
+                    case 0:
+                        for (const uint32_t id: held) {
+                            allocator.free(id);
+                        }
+                        break;
+                    case 1:
+                        for (const uint32_t id: held) {
+                            cache.free(id);
+                        }
+                        break;
+                    default:
+                        allocator.freeBulk(held.data(), held.size());
+                        break;
+                }
+                held.clear();
+            }
+            for (const uint32_t id: held) {
+                release(id);
+                allocator.free(id);
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    Log("GIDAllocator {} threads, {} rounds: duplicates = {}, stale = {}, high water = {}",
+        threadCount, rounds, duplicates.load(), stale.load(), allocator.highWater());
+    return duplicates.load() == 0 && stale.load() == 0;
+}
+
+/**
+ * Bulk calls larger than one internal batch, for the ID widths that do not match the internal 32-bit IDs
+ */
+template<typename ID_TYPE>
+static bool bulk()
+{
+    constexpr size_t COUNT = 1000;
+    GIDAllocator<ID_TYPE> allocator;
+    std::vector<ID_TYPE> ids(COUNT);
+    bool ok = allocator.allocBulk(ids.data(), COUNT) == COUNT;
+    std::vector<ID_TYPE> sorted = ids;
+    std::sort(sorted.begin(), sorted.end());
+    ok &= sorted.front() != 0 && std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end();
+    for (const ID_TYPE id: ids) {
+        ok &= allocator.isValid(id);
+    }
+    allocator.freeBulk(ids.data(), COUNT);
+    for (const ID_TYPE id: ids) {
+        ok &= !allocator.isValid(id);
+    }
+    // Every freed ID is reused before a fresh one
+    ok &= allocator.allocBulk(ids.data(), COUNT) == COUNT && allocator.highWater() == COUNT + 1;
+    return ok;
+}
+
+/**
+ * A freed ID comes back with a new generation, the handle from before is stale
+ */
+static bool generations()
+{
+    GIDAllocator<uint32_t> allocator;
+    const uint32_t id = allocator.alloc();
+    const uint32_t generation = allocator.generation(id);
+    allocator.free(id);
+    allocator.free(id);
+    const uint32_t again = allocator.alloc();
+    return again == id && !allocator.isValid(id, generation) && allocator.isValid(again, allocator.generation(again));
+}
+
+int main(int argc, char *argv[])
+{
+    bool ok = true;
+    ok &= exhaust<uint16_t, std::numeric_limits<uint16_t>::max()>("GIDAllocator<uint16_t>", 65534);
+    ok &= exhaust<uint32_t, 5000>("GIDAllocator<uint32_t, 5000>", 4999);
+    ok &= generations();
+    ok &= bulk<uint16_t>();
+    ok &= bulk<uint64_t>();
+    ok &= stress(4, 200000);
+    ok &= stress(8, 50000);
+
+    Log("{}", ok ? "All passed" : "FAILED");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
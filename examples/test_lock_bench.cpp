@@ -0,0 +1,184 @@
+//
+// Created by Gxin on 2024/4/2.
+//
+
+#include <gx/gmutex.h>
+#include <gx/allocator.h>
+#include <gx/gtime.h>
+
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+constexpr size_t TOTAL_OPS = 2000000;
+constexpr size_t MAX_THREADS = 64;
+
+/**
+ * Counters touched inside the critical section, a few cache lines like a small shared structure
+ */
+struct alignas(GX_CACHE_LINE_SIZE) Shared
+{
+    uint64_t values[16] = {};
+};
+
+template<typename LOCK>
+static void contention(const char *name, LOCK &lock, size_t threadCount, size_t workOutside)
+{
+    Shared shared;
+    const size_t opsPerThread = TOTAL_OPS / threadCount;
+
+    const GTime t0 = GTime::currentSteadyTime();
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < threadCount; t++) {
+        threads.emplace_back([&, t] {
+            volatile uint64_t local = t;
+            for (size_t i = 0; i < opsPerThread; i++) {
+                {
+                    GLockerGuard locker(lock);
+                    for (auto &v: shared.values) {
+                        v += i;
+                    }
+                }
+                for (size_t w = 0; w < workOutside; w++) {
+                    local = local * 31 + w;
+                }
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    const GTime t1 = GTime::currentSteadyTime();
+
+    Log("{} x{} threads, {} work: {} ns/op", name, threadCount, workOutside,
+        static_cast<double>(t1.nanoSecsTo(t0)) / static_cast<double>(opsPerThread * threadCount));
+}
+
+static void contentionScaling(size_t workOutside)
+{
+    for (size_t threadCount = 1; threadCount <= MAX_THREADS; threadCount *= 2) {
+        GMutex mutex;
+        contention("GMutex", mutex, threadCount, workOutside);
+        GSpinLock spinLock;
+        contention("GSpinLock", spinLock, threadCount, workOutside);
+        GAdaptiveLock adaptiveLock;
+        contention("GAdaptiveLock", adaptiveLock, threadCount, workOutside);
+    }
+}
+
+/**
+ * Pool arena shared by every thread, alloc and free both take the lock
+ */
+template<typename LOCKING>
+static void sharedPool(const char *name, size_t threadCount)
+{
+    GArena<GPoolAllocator<64, 16>, LOCKING> arena(name);
+    const size_t opsPerThread = TOTAL_OPS / 4 / threadCount;
+
+    const GTime t0 = GTime::currentSteadyTime();
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < threadCount; t++) {
+        threads.emplace_back([&] {
+            void *live[8] = {};
+            for (size_t i = 0; i < opsPerThread; i++) {
+                void *&slot = live[i % 8];
+                if (slot) {
+                    arena.free(slot);
+                }
+                slot = arena.alloc(64, 16);
+            }
+            for (void *p: live) {
+                if (p) {
+                    arena.free(p);
+                }
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    const GTime t1 = GTime::currentSteadyTime();
+
+    Log("GPoolAllocator + {} x{} threads: {} ns/op", name, threadCount,
+        static_cast<double>(t1.nanoSecsTo(t0)) / static_cast<double>(opsPerThread * threadCount));
+}
+
+/**
+ * Registry style lookups, one write every WRITE_INTERVAL reads
+ */
+template<typename RWLOCK>
+static void readMostly(const char *name, size_t threadCount)
+{
+    constexpr size_t WRITE_INTERVAL = 1000;
+
+    RWLOCK lock;
+    std::map<int32_t, int32_t> registry;
+    for (int32_t i = 0; i < 64; i++) {
+        registry[i] = i;
+    }
+    const size_t opsPerThread = TOTAL_OPS / 2 / threadCount;
+
+    const GTime t0 = GTime::currentSteadyTime();
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < threadCount; t++) {
+        threads.emplace_back([&, t] {
+            int64_t sum = 0;
+            for (size_t i = 0; i < opsPerThread; i++) {
+                const auto key = static_cast<int32_t>((i + t) % 64);
+                if ((i + t * 7) % WRITE_INTERVAL == 0) {
+                    auto guard = lock.writeGuard();
+                    registry[key]++;
+                } else {
+                    auto guard = lock.readGuard();
+                    sum += registry.find(key)->second;
+                }
+            }
+            GX_ASSERT(sum >= 0);
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    const GTime t1 = GTime::currentSteadyTime();
+
+    Log("{} x{} threads: {} ns/op", name, threadCount,
+        static_cast<double>(t1.nanoSecsTo(t0)) / static_cast<double>(opsPerThread * threadCount));
+}
+
+int main(int argc, char *argv[])
+{
+    Log("hardware concurrency: {}", std::thread::hardware_concurrency());
+
+    Log("-- Short critical section, no work outside the lock --");
+    contentionScaling(0);
+    Log("-- Short critical section, some work outside the lock --");
+    contentionScaling(200);
+
+    Log("-- Read mostly, 0.1% writes --");
+    for (size_t threadCount = 1; threadCount <= MAX_THREADS; threadCount *= 2) {
+        readMostly<GRWLock>("GRWLock", threadCount);
+        readMostly<GSpinRWLock>("GSpinRWLock", threadCount);
+        readMostly<GReaderBiasedRWLock>("GReaderBiasedRWLock", threadCount);
+    }
+
+    Log("-- Shared arena --");
+    for (size_t threadCount = 1; threadCount <= MAX_THREADS; threadCount *= 4) {
+        sharedPool<GLockingPolicy::Mutex>("Mutex", threadCount);
+        sharedPool<GLockingPolicy::SpinLock>("SpinLock", threadCount);
+        sharedPool<GLockingPolicy::Adaptive>("Adaptive", threadCount);
+    }
+
+    // Profiled explicitly here, GX_LOCK_PROFILING profiles every GMutex, GSpinLock... the same way
+    Log("-- Profiling overhead --");
+    for (size_t threadCount = 1; threadCount <= MAX_THREADS; threadCount *= 8) {
+        GProfiledLock<GRawSpinLock> spinLock("spin lock");
+        contention("GProfiledLock<GRawSpinLock>", spinLock, threadCount, 200);
+        GProfiledLock<GRawAdaptiveLock> adaptiveLock("adaptive lock");
+        contention("GProfiledLock<GRawAdaptiveLock>", adaptiveLock, threadCount, 200);
+    }
+    GLockRegistry::dump();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,191 @@
+//
+// Created by Gxin on 2024/4/1.
+//
+
+#include <gx/gslotmap.h>
+#include <gx/gtime.h>
+
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+
+constexpr size_t ELEMENT_COUNT = 200000;
+constexpr size_t LOOKUP_COUNT = 2000000;
+constexpr int32_t ROUNDS = 20;
+
+struct Particle
+{
+    float position[3];
+    float velocity[3];
+};
+
+static void benchSlotMap(const std::vector<size_t> &lookupOrder)
+{
+    GSlotMap<Particle> map;
+    std::vector<GSlotMap<Particle>::Handle> handles(ELEMENT_COUNT);
+
+    GTime t0 = GTime::currentSteadyTime();
+    for (size_t i = 0; i < ELEMENT_COUNT; i++) {
+        handles[i] = map.insert(Particle{{float(i), 0, 0}, {1, 1, 1}});
+    }
+    GTime t1 = GTime::currentSteadyTime();
+    const int64_t insertNs = t1.nanoSecsTo(t0);
+
+    float sum = 0;
+    t0 = GTime::currentSteadyTime();
+    for (const size_t i: lookupOrder) {
+        sum += map.get(handles[i])->position[0];
+    }
+    t1 = GTime::currentSteadyTime();
+    const int64_t lookupNs = t1.nanoSecsTo(t0);
+
+    t0 = GTime::currentSteadyTime();
+    for (int32_t r = 0; r < ROUNDS; r++) {
+        for (auto &p: map) {
+            p.position[0] += p.velocity[0];
+        }
+    }
+    t1 = GTime::currentSteadyTime();
+    const int64_t iterateNs = t1.nanoSecsTo(t0);
+
+    // Erase every other element then insert them again, the old handles must all be stale
+    t0 = GTime::currentSteadyTime();
+    for (size_t i = 0; i < ELEMENT_COUNT; i += 2) {
+        map.erase(handles[i]);
+    }
+    size_t stale = 0;
+    for (size_t i = 0; i < ELEMENT_COUNT; i += 2) {
+        stale += map.get(handles[i]) == nullptr;
+        handles[i] = map.insert(Particle{});
+    }
+    t1 = GTime::currentSteadyTime();
+    const int64_t churnNs = t1.nanoSecsTo(t0);
+
+    Log("GSlotMap: insert {} ns, lookup {} ns, iterate {} ns/element, erase+insert {} ns, stale handles detected {}/{} ({})",
+        insertNs / (int64_t) ELEMENT_COUNT, lookupNs / (int64_t) LOOKUP_COUNT,
+        static_cast<double>(iterateNs) / (ELEMENT_COUNT * ROUNDS), churnNs / (int64_t) ELEMENT_COUNT,
+        stale, ELEMENT_COUNT / 2, sum);
+}
+
+static void benchUnorderedMap(const std::vector<size_t> &lookupOrder)
+{
+    std::unordered_map<uint64_t, Particle> map;
+    std::vector<uint64_t> ids(ELEMENT_COUNT);
+    uint64_t nextId = 1;
+
+    GTime t0 = GTime::currentSteadyTime();
+    for (size_t i = 0; i < ELEMENT_COUNT; i++) {
+        ids[i] = nextId++;
+        map.emplace(ids[i], Particle{{float(i), 0, 0}, {1, 1, 1}});
+    }
+    GTime t1 = GTime::currentSteadyTime();
+    const int64_t insertNs = t1.nanoSecsTo(t0);
+
+    float sum = 0;
+    t0 = GTime::currentSteadyTime();
+    for (const size_t i: lookupOrder) {
+        sum += map.find(ids[i])->second.position[0];
+    }
+    t1 = GTime::currentSteadyTime();
+    const int64_t lookupNs = t1.nanoSecsTo(t0);
+
+    t0 = GTime::currentSteadyTime();
+    for (int32_t r = 0; r < ROUNDS; r++) {
+        for (auto &it: map) {
+            it.second.position[0] += it.second.velocity[0];
+        }
+    }
+    t1 = GTime::currentSteadyTime();
+    const int64_t iterateNs = t1.nanoSecsTo(t0);
+
+    t0 = GTime::currentSteadyTime();
+    for (size_t i = 0; i < ELEMENT_COUNT; i += 2) {
+        map.erase(ids[i]);
+    }
+    for (size_t i = 0; i < ELEMENT_COUNT; i += 2) {
+        ids[i] = nextId++;
+        map.emplace(ids[i], Particle{});
+    }
+    t1 = GTime::currentSteadyTime();
+    const int64_t churnNs = t1.nanoSecsTo(t0);
+
+    Log("std::unordered_map: insert {} ns, lookup {} ns, iterate {} ns/element, erase+insert {} ns ({})",
+        insertNs / (int64_t) ELEMENT_COUNT, lookupNs / (int64_t) LOOKUP_COUNT,
+        static_cast<double>(iterateNs) / (ELEMENT_COUNT * ROUNDS), churnNs / (int64_t) ELEMENT_COUNT, sum);
+}
+
+/**
+ * A value constructor throwing in emplace() leaves the map as it was, with the free list untouched
+ */
+static bool exceptionSafety()
+{
+    struct Fragile
+    {
+        explicit Fragile(int32_t v)
+                : value(v)
+        {
+            if (v < 0) {
+                throw std::runtime_error("fragile");
+            }
+        }
+
+        int32_t value;
+    };
+
+    GSlotMap<Fragile> map;
+    std::vector<GSlotMap<Fragile>::Handle> handles;
+    for (int32_t i = 0; i < 10; i++) {
+        handles.push_back(map.emplace(i));
+    }
+    map.erase(handles[3]);
+
+    int32_t thrown = 0;
+    for (int32_t i = 0; i < 2; i++) {
+        try {
+            map.emplace(-1);
+        } catch (const std::runtime_error &) {
+            thrown++;
+        }
+    }
+
+    bool ok = thrown == 2 && map.size() == 9;
+    // The freed slot is reused, every value is still reached by its handle
+    handles[3] = map.emplace(3);
+    ok &= GSlotMap<Fragile>::indexOf(handles[3]) == 3;
+    for (int32_t i = 0; i < 10; i++) {
+        ok &= map.get(handles[i]) && map.get(handles[i])->value == i;
+    }
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<size_t> dist(0, ELEMENT_COUNT - 1);
+    std::vector<size_t> lookupOrder(LOOKUP_COUNT);
+    for (auto &i: lookupOrder) {
+        i = dist(rng);
+    }
+
+    benchSlotMap(lookupOrder);
+    benchUnorderedMap(lookupOrder);
+
+    // 32-bit handles with 4 generation bits, a hot slot is retired once its generations run out
+    GSlotMap<int32_t, uint32_t, 28> small;
+    GSlotMap<int32_t, uint32_t, 28>::Handle first = small.insert(0);
+    GSlotMap<int32_t, uint32_t, 28>::Handle last = first;
+    for (int32_t i = 0; i < 100; i++) {
+        small.erase(last);
+        last = small.insert(i);
+    }
+    Log("GSlotMap 32-bit handles: max generation {}, first handle stale {}, exhausted slot retired {}",
+        GSlotMap<int32_t, uint32_t, 28>::MAX_GENERATION, !small.contains(first),
+        GSlotMap<int32_t, uint32_t, 28>::indexOf(first) != GSlotMap<int32_t, uint32_t, 28>::indexOf(last));
+
+    const bool safe = exceptionSafety();
+    Log("GSlotMap emplace with a throwing constructor: {}", safe);
+
+    return safe ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -51,6 +51,12 @@ int main(int argc, char *argv[])
 
     taskSystem.stopAndWait();
 
+    const auto stats = taskSystem.taskStats();
+    Log("Task wait time(ns): count = {}, p50 = {}, p99 = {}, max = {}",
+        stats.waitTime.count, stats.waitTime.percentile(50), stats.waitTime.percentile(99), stats.waitTime.max);
+    Log("Task exec time(ns): count = {}, p50 = {}, p99 = {}, max = {}",
+        stats.execTime.count, stats.execTime.percentile(50), stats.execTime.percentile(99), stats.execTime.max);
+
     Log("End");
 
     return EXIT_SUCCESS;
@@ -30,6 +30,9 @@ int main(int argc, char *argv[])
     ATimer timer3;
     GTimer timer4(scheduler);    // 一次性计时器
     timer4.setOneShot();
+    GTimer timer5(scheduler);    // 固定频率计时器, 按起始时间对齐, 回调耗时不会累积漂移
+    timer5.setSchedule(GTimerSchedule::FixedRate);
+    timer5.setMissedTickPolicy(GTimerMissedTickPolicy::Coalesce);
 
     uint32_t counter = 0;
 
@@ -53,11 +56,20 @@ int main(int argc, char *argv[])
     timer4.timerEvent([&]() {
         Log("Timer4 timeout.");
     });
+
+    int32_t timer5Ticks = 0;
+    timer5.timerTickEvent([&](int64_t missedTicks) {
+        Log("Timer5 timeout, missed ticks: {}", missedTicks);
+        if (++timer5Ticks == 2) {
+            GThread::mSleep(1100);  // 错过两个周期, Coalesce 策略下合并为一次回调
+        }
+    });
     timer1.start(0, 1000);  // 立即执行一次, 之后每1000ms执行一次
     timer2.start(500);    // 每500ms执行一次检查，当条件达成时执行 timerEvent
     timer3.start(1000);     // 每1000ms执行一次
     timer4.start(500);
     timer4.start(1000);     // 重新开始, 会覆盖上一个计时任务, 并从头计时
+    timer5.start(500);
 
     // 直接通过 GTimerScheduler 提交一次性任务
     GTimerScheduler::global()->post([]() {
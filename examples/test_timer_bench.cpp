@@ -0,0 +1,121 @@
+//
+// Created by Gxin on 2024/3/20.
+//
+
+#include <gx/gtimer.h>
+#include <gx/gthread.h>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+
+static const char *backendName(GTimerScheduler::Backend backend)
+{
+    return backend == GTimerScheduler::Backend::Wheel ? "Wheel" : "Heap";
+}
+
+static void benchBackend(GTimerScheduler::Backend backend, size_t count)
+{
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int64_t> idleTimeout(1000, 60000);
+    std::uniform_int_distribution<int64_t> shortTimeout(0, 50);
+
+    // Insert and cancel long connection timeouts
+    {
+        const auto scheduler = GTimerScheduler::create("Bench", backend);
+        scheduler->start();
+
+        std::vector<GTimerScheduler::GTimerTaskPtr> tasks;
+        tasks.reserve(count);
+
+        GTime t0 = GTime::currentSteadyTime();
+        for (size_t i = 0; i < count; i++) {
+            tasks.push_back(scheduler->post([] {
+            }, idleTimeout(rng)));
+        }
+        GTime t1 = GTime::currentSteadyTime();
+        for (const auto &task: tasks) {
+            task->cancel();
+        }
+        GTime t2 = GTime::currentSteadyTime();
+
+        Log("{} x{}: insert {} ns/timer, cancel {} ns/timer, after cancel live: {}, dead: {}",
+            backendName(backend), count,
+            t1.nanoSecsTo(t0) / (int64_t) count,
+            t2.nanoSecsTo(t1) / (int64_t) count,
+            scheduler->taskCount(),
+            scheduler->deadTaskCount());
+    }
+
+    // Expire short timeouts
+    {
+        const auto scheduler = GTimerScheduler::create("Bench", backend);
+        scheduler->start();
+
+        size_t fired = 0;
+        for (size_t i = 0; i < count; i++) {
+            scheduler->post([&fired] {
+                ++fired;
+            }, shortTimeout(rng));
+        }
+        GThread::mSleep(60);
+
+        GTime t0 = GTime::currentSteadyTime();
+        while (fired < count) {
+            scheduler->loop(INT64_MAX);
+        }
+        GTime t1 = GTime::currentSteadyTime();
+
+        Log("{} x{}: expire {} ns/timer", backendName(backend), count, t1.nanoSecsTo(t0) / (int64_t) count);
+    }
+}
+
+/**
+ * Periodic timers a few hundred microseconds apart, every one of them wakes the scheduler up unless they have slack
+ */
+static void benchSlack(GTimerScheduler::Backend backend, int64_t slackUs)
+{
+    constexpr int32_t TIMER_COUNT = 50;
+    constexpr int64_t INTERVAL_US = 20000;
+
+    GTimerScheduler::Options options;
+    options.backend = backend;
+    options.wheelTick = 100000;
+    const auto scheduler = GTimerScheduler::create("Slack", options);
+
+    std::vector<std::unique_ptr<GTimer>> timers;
+    for (int32_t i = 0; i < TIMER_COUNT; i++) {
+        auto timer = std::make_unique<GTimer>(scheduler);
+        timer->setSchedule(GTimerSchedule::FixedRate);
+        timer->setSlackMicroSecs(slackUs);
+        timer->timerEvent([] {
+        });
+        timer->startMicroSecs(INTERVAL_US * i / TIMER_COUNT, INTERVAL_US);
+        timers.push_back(std::move(timer));
+    }
+    scheduler->post([scheduler] {
+        scheduler->stop(false);
+    }, 1000);
+    scheduler->resetWakeupStats();
+    scheduler->run();
+
+    const auto stats = scheduler->takeWakeupStats();
+    Log("{} slack {}us: {} wakeups/s, {} timers/wakeup",
+        backendName(backend), slackUs, stats.wakeupsPerSecond(), stats.tasksPerWakeup());
+}
+
+int main(int argc, char *argv[])
+{
+    for (int64_t slackUs: {0, 1000, 5000}) {
+        benchSlack(GTimerScheduler::Backend::Heap, slackUs);
+        benchSlack(GTimerScheduler::Backend::Wheel, slackUs);
+    }
+
+    for (size_t count: {10000, 100000, 1000000}) {
+        benchBackend(GTimerScheduler::Backend::Heap, count);
+        benchBackend(GTimerScheduler::Backend::Wheel, count);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,141 @@
+//
+// Created by Gxin on 2024/3/26.
+//
+
+#include <gx/gtimer.h>
+#include <gx/gthread.h>
+#include <gx/gtasksystem.h>
+#include <gx/gjobsystem.h>
+#include <gx/ghistogram.h>
+
+#include <thread>
+
+
+constexpr int64_t FAST_INTERVAL_MS = 5;
+constexpr int64_t SLOW_INTERVAL_MS = 20;
+constexpr int64_t SLOW_WORK_MS = 50;
+constexpr int64_t RUN_TIME_MS = 1000;
+
+/**
+ * A fast fixed-rate timer running on the scheduler thread next to a slow one whose callback takes longer than its interval.
+ * Inline, the slow callback holds the scheduler thread and the fast timer fires late.
+ */
+static void measure(const char *name, const GTimerExecutor &executor, GTimerConcurrency concurrency)
+{
+    const auto scheduler = GTimerScheduler::create("Executor");
+
+    GHistogram lateness;
+    int64_t expected = 0;
+    GTimer fast(scheduler);
+    fast.setSchedule(GTimerSchedule::FixedRate);
+    fast.timerEvent([&] {
+        const int64_t now = GTime::currentSteadyTime().nanosecond();
+        lateness.record(static_cast<uint64_t>(std::max<int64_t>(now - expected, 0)));
+        expected += FAST_INTERVAL_MS * 1000000;
+    });
+
+    std::atomic<int32_t> slowRuns{0};
+    std::atomic<int32_t> slowActive{0};
+    std::atomic<int32_t> slowMaxActive{0};
+    std::atomic<int64_t> slowMissed{0};
+    GTimer slow(scheduler);
+    slow.setSchedule(GTimerSchedule::FixedRate);
+    slow.setMissedTickPolicy(GTimerMissedTickPolicy::Coalesce);
+    slow.setExecutor(executor, concurrency);
+    slow.timerTickEvent([&](int64_t missedTicks) {
+        const int32_t active = slowActive.fetch_add(1) + 1;
+        int32_t maxActive = slowMaxActive.load();
+        while (active > maxActive && !slowMaxActive.compare_exchange_weak(maxActive, active)) {
+        }
+        GThread::mSleep(SLOW_WORK_MS);
+        slowMissed.fetch_add(missedTicks);
+        slowRuns.fetch_add(1);
+        slowActive.fetch_sub(1);
+    });
+
+    expected = GTime::currentSteadyTime().nanosecond() + FAST_INTERVAL_MS * 1000000;
+    fast.start(FAST_INTERVAL_MS);
+    slow.start(SLOW_INTERVAL_MS);
+    scheduler->post([scheduler] {
+        scheduler->stop(false);
+    }, RUN_TIME_MS);
+    scheduler->run();
+
+    fast.stop();
+    // Waits for the dispatched run in progress
+    slow.stop();
+
+    const auto s = lateness.snapshot();
+    Log("{}: fast timer lateness(us) p50 = {}, p99 = {}, max = {}; slow timer runs = {}, missed ticks = {}, max overlap = {}",
+        name,
+        s.percentile(50) / 1000.0, s.percentile(99) / 1000.0, s.max / 1000.0,
+        slowRuns.load(), slowMissed.load(), slowMaxActive.load());
+}
+
+/**
+ * stop() returns only after the run in progress is over, and a timer can stop itself from its own event
+ */
+static bool stopWaitsForRuns(const GTimerExecutor &executor)
+{
+    const auto scheduler = GTimerScheduler::create("StopWaits");
+    std::thread driver([scheduler] {
+        scheduler->run();
+    });
+
+    std::atomic<bool> started{false};
+    std::atomic<bool> finished{false};
+    GTimer timer(scheduler);
+    timer.setExecutor(executor, GTimerConcurrency::Parallel);
+    timer.timerEvent([&] {
+        started.store(true);
+        GThread::mSleep(SLOW_WORK_MS);
+        finished.store(true);
+    });
+    timer.start(1);
+    while (!started.load()) {
+        GThread::mSleep(1);
+    }
+    timer.stop();
+    const bool waited = finished.load();
+
+    std::atomic<int32_t> selfRuns{0};
+    GTimer self(scheduler);
+    self.setExecutor(executor);
+    self.timerEvent([&] {
+        selfRuns.fetch_add(1);
+        self.stop();
+    });
+    self.start(1);
+    while (selfRuns.load() == 0) {
+        GThread::mSleep(1);
+    }
+    GThread::mSleep(SLOW_INTERVAL_MS);
+    const bool stopped = selfRuns.load() == 1;
+
+    scheduler->stop();
+    driver.join();
+    Log("stop() waits for the run in progress: {}, stops from its own event: {}", waited, stopped);
+    return waited && stopped;
+}
+
+int main(int argc, char *argv[])
+{
+    bool ok = true;
+    ok &= stopWaitsForRuns(nullptr);
+
+    measure("Inline", nullptr, GTimerConcurrency::Serial);
+
+    GTaskSystem taskSystem("TimerTasks", 4);
+    taskSystem.start();
+    const auto taskExecutor = GTimerScheduler::executorOf(&taskSystem);
+    measure("TaskSystem Serial", taskExecutor, GTimerConcurrency::Serial);
+    measure("TaskSystem SkipOverlap", taskExecutor, GTimerConcurrency::SkipOverlap);
+    measure("TaskSystem Parallel", taskExecutor, GTimerConcurrency::Parallel);
+    ok &= stopWaitsForRuns(taskExecutor);
+    taskSystem.stopAndWait();
+
+    GJobSystem jobSystem("TimerJobs", 4);
+    measure("JobSystem SkipOverlap", GTimerScheduler::executorOf(&jobSystem), GTimerConcurrency::SkipOverlap);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
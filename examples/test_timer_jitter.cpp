@@ -0,0 +1,71 @@
+//
+// Created by Gxin on 2024/3/23.
+//
+
+#include <gx/gtimer.h>
+#include <gx/gthread.h>
+#include <gx/ghistogram.h>
+
+
+constexpr int64_t INTERVAL_US = 200;
+constexpr int32_t SAMPLE_COUNT = 2000;
+
+struct JitterProbe
+{
+    GTimerSchedulerPtr scheduler;
+    GHistogram lateness;
+    int64_t expected = 0;
+    int32_t remaining = SAMPLE_COUNT;
+
+    void arm()
+    {
+        expected = GTime::currentSteadyTime().nanosecond() + INTERVAL_US * 1000;
+        scheduler->postMicroSecs([this] {
+            fire();
+        }, INTERVAL_US);
+    }
+
+    void fire()
+    {
+        const int64_t now = GTime::currentSteadyTime().nanosecond();
+        lateness.record(static_cast<uint64_t>(std::max<int64_t>(now - expected, 0)));
+        if (--remaining > 0) {
+            arm();
+        } else {
+            scheduler->stop();
+        }
+    }
+};
+
+static void measure(const char *name, const GTimerScheduler::Options &options)
+{
+    JitterProbe probe;
+    probe.scheduler = GTimerScheduler::create("Jitter", options);
+    probe.arm();
+    probe.scheduler->run();
+
+    const auto s = probe.lateness.snapshot();
+    Log("{}: wakeup lateness(us) p50 = {}, p90 = {}, p99 = {}, max = {}",
+        name,
+        s.percentile(50) / 1000.0, s.percentile(90) / 1000.0, s.percentile(99) / 1000.0, s.max / 1000.0);
+}
+
+int main(int argc, char *argv[])
+{
+    GTimerScheduler::Options options;
+
+    options.waitMode = GTimerScheduler::WaitMode::Default;
+    measure("Condition", options);
+
+    options.waitMode = GTimerScheduler::WaitMode::Precise;
+    measure("Precise", options);
+
+    options.spinTime = 50000;
+    measure("Precise + 50us spin", options);
+
+    options.backend = GTimerScheduler::Backend::Wheel;
+    options.wheelTick = 10000;
+    measure("Precise + 50us spin, 10us wheel", options);
+
+    return EXIT_SUCCESS;
+}
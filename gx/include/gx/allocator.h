@@ -12,8 +12,16 @@
 #include "debug.h"
 
 #include <memory.h>
+#include <algorithm>
 #include <atomic>
+#include <bit>
+#include <map>
+#include <memory>
+#include <new>
 #include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 
 namespace pointer
@@ -181,12 +189,478 @@ private:
     { return pointer::add(mBegin, mCur); }
 
     void set_current(void *p) noexcept
-    { mCur = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(p) - reinterpret_cast<uintptr_t>(mBegin)); }
+    { mCur = static_cast<size_t>(reinterpret_cast<uintptr_t>(p) - reinterpret_cast<uintptr_t>(mBegin)); }
 
 private:
     void *mBegin = nullptr;
-    uint32_t mSize = 0;
-    uint32_t mCur = 0;
+    size_t mSize = 0;
+    size_t mCur = 0;
+};
+
+
+/**
+ * @class GChainedLinearAllocator
+ * @brief Linear allocator that chains a new heap block when the current one is exhausted.
+ * Block sizes grow geometrically from the initial size, the total can be capped (0: no limit).
+ * The cap counts the spare block kept by reset(), the last block is shrunk to fit under it.
+ * getCurrent()/rewind() work across block boundaries, the blocks allocated after the marker are released.
+ * reset() keeps only the largest block, so a steady per-frame or per-request workload stops calling malloc.
+ */
+class GChainedLinearAllocator
+{
+public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+public:
+    explicit GChainedLinearAllocator(size_t initialBlockSize = DEFAULT_BLOCK_SIZE,
+                                     size_t maxCapacity = 0,
+                                     size_t growthFactor = 2) noexcept
+            : mNextBlockSize(std::max<size_t>(initialBlockSize, 1)),
+              mMaxCapacity(maxCapacity),
+              mGrowthFactor(std::max<size_t>(growthFactor, 1))
+    {
+    }
+
+    /**
+     * @brief The area is not used, blocks always come from the heap
+     */
+    template<typename AREA, typename = std::enable_if_t<!std::is_arithmetic_v<AREA>>>
+    explicit GChainedLinearAllocator(const AREA &,
+                                     size_t initialBlockSize = DEFAULT_BLOCK_SIZE,
+                                     size_t maxCapacity = 0,
+                                     size_t growthFactor = 2) noexcept
+            : GChainedLinearAllocator(initialBlockSize, maxCapacity, growthFactor)
+    {
+    }
+
+    GChainedLinearAllocator(const GChainedLinearAllocator &rhs) = delete;
+
+    GChainedLinearAllocator &operator=(const GChainedLinearAllocator &rhs) = delete;
+
+    GChainedLinearAllocator(GChainedLinearAllocator &&rhs) noexcept
+    {
+        this->swap(rhs);
+    }
+
+    GChainedLinearAllocator &operator=(GChainedLinearAllocator &&rhs) noexcept
+    {
+        if (this != &rhs) {
+            this->swap(rhs);
+        }
+        return *this;
+    }
+
+    ~GChainedLinearAllocator() noexcept
+    {
+        while (mHead) {
+            Block *const prev = mHead->prev;
+            gx::alignedFree(mHead);
+            mHead = prev;
+        }
+        gx::alignedFree(mSpare);
+    }
+
+public:
+    void *alloc(size_t size, size_t alignment = alignof(std::max_align_t), size_t extra = 0)
+    {
+        void *const p = pointer::align(mCur, alignment, extra);
+        void *const c = pointer::add(p, size);
+        if (mHead && c <= mEnd) {
+            mCur = static_cast<char *>(c);
+            return p;
+        }
+        if (!grow(size + alignment + extra)) {
+            return nullptr;
+        }
+        void *const q = pointer::align(mCur, alignment, extra);
+        mCur = static_cast<char *>(pointer::add(q, size));
+        GX_ASSERT(mCur <= mEnd);
+        return q;
+    }
+
+    /**
+     * @brief Marker for rewind()
+     */
+    void *getCurrent() noexcept
+    {
+        return mCur;
+    }
+
+    /**
+     * @brief Roll back to a marker returned by getCurrent(), possibly in an earlier block
+     * @param p
+     */
+    void rewind(void *p) noexcept
+    {
+        while (mHead && !(p >= dataOf(mHead) && p <= endOf(mHead))) {
+            Block *const block = mHead;
+            mHead = block->prev;
+            release(block);
+        }
+        if (!mHead) {
+            // Marker taken before the first block
+            GX_ASSERT(p == nullptr);
+            mCur = mEnd = nullptr;
+            return;
+        }
+        mCur = static_cast<char *>(p);
+        mEnd = endOf(mHead);
+    }
+
+    /**
+     * @brief Release everything, the largest block is kept for the next round
+     */
+    void reset() noexcept
+    {
+        while (mHead) {
+            Block *const block = mHead;
+            mHead = block->prev;
+            release(block);
+        }
+        if (mSpare) {
+            mHead = mSpare;
+            mSpare = nullptr;
+            mHead->prev = nullptr;
+            mHead->usedBefore = 0;
+            mCapacity += mHead->size;
+            mCur = dataOf(mHead);
+            mEnd = endOf(mHead);
+        } else {
+            mCur = mEnd = nullptr;
+        }
+    }
+
+    /**
+     * @brief Bytes handed out since the last reset, including alignment padding
+     */
+    size_t size() const noexcept
+    {
+        return mHead ? mHead->usedBefore + static_cast<size_t>(mCur - dataOf(mHead)) : 0;
+    }
+
+    /**
+     * @brief Bytes of the blocks in use
+     */
+    size_t capacity() const noexcept
+    {
+        return mCapacity;
+    }
+
+    size_t blockCount() const noexcept
+    {
+        size_t count = 0;
+        for (const Block *b = mHead; b; b = b->prev) {
+            ++count;
+        }
+        return count;
+    }
+
+    void swap(GChainedLinearAllocator &rhs) noexcept
+    {
+        std::swap(mHead, rhs.mHead);
+        std::swap(mSpare, rhs.mSpare);
+        std::swap(mCur, rhs.mCur);
+        std::swap(mEnd, rhs.mEnd);
+        std::swap(mCapacity, rhs.mCapacity);
+        std::swap(mNextBlockSize, rhs.mNextBlockSize);
+        std::swap(mMaxCapacity, rhs.mMaxCapacity);
+        std::swap(mGrowthFactor, rhs.mGrowthFactor);
+    }
+
+    void free(void *) noexcept
+    {}
+
+    void free(void *, size_t) noexcept
+    {}
+
+private:
+    struct Block
+    {
+        Block *prev;
+        size_t size;        ///< Usable bytes after the header
+        size_t usedBefore;  ///< Bytes used in the previous blocks when this one was chained
+    };
+
+    static constexpr size_t BLOCK_HEADER_SIZE = (sizeof(Block) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+    static char *dataOf(const Block *block) noexcept
+    {
+        return reinterpret_cast<char *>(const_cast<Block *>(block)) + BLOCK_HEADER_SIZE;
+    }
+
+    static char *endOf(const Block *block) noexcept
+    {
+        return dataOf(block) + block->size;
+    }
+
+    bool grow(size_t minSize) noexcept
+    {
+        Block *block = nullptr;
+        if (mSpare && mSpare->size >= minSize) {
+            block = mSpare;
+            mSpare = nullptr;
+        } else {
+            size_t blockSize = std::max(mNextBlockSize, minSize);
+            if (mMaxCapacity) {
+                // The spare is too small for this request, give it back before the cap rejects a new block
+                if (mSpare && mCapacity + mSpare->size + blockSize > mMaxCapacity) {
+                    gx::alignedFree(mSpare);
+                    mSpare = nullptr;
+                }
+                const size_t room = mMaxCapacity - std::min(mCapacity + (mSpare ? mSpare->size : 0), mMaxCapacity);
+                if (room < minSize) {
+                    return false;
+                }
+                blockSize = std::min(blockSize, room);
+            }
+            block = static_cast<Block *>(gx::alignedAlloc(BLOCK_HEADER_SIZE + blockSize, alignof(std::max_align_t)));
+            if (!block) {
+                return false;
+            }
+            block->size = blockSize;
+            mNextBlockSize = blockSize * mGrowthFactor;
+        }
+        block->usedBefore = size();
+        block->prev = mHead;
+        mHead = block;
+        mCapacity += block->size;
+        mCur = dataOf(block);
+        mEnd = endOf(block);
+        return true;
+    }
+
+    /**
+     * @brief Keep the largest released block as a spare, free the others
+     */
+    void release(Block *block) noexcept
+    {
+        mCapacity -= block->size;
+        if (!mSpare || mSpare->size < block->size) {
+            std::swap(mSpare, block);
+        }
+        gx::alignedFree(block);
+    }
+
+private:
+    Block *mHead = nullptr;
+    Block *mSpare = nullptr;
+    char *mCur = nullptr;
+    char *mEnd = nullptr;
+    size_t mCapacity = 0;
+    size_t mNextBlockSize = DEFAULT_BLOCK_SIZE;
+    size_t mMaxCapacity = 0;
+    size_t mGrowthFactor = 2;
+};
+
+
+/**
+ * @class GConcurrentLinearAllocator
+ * @brief Linear allocator that can be shared by several threads without a lock,
+ * alloc() is a single atomic fetch-add on the cursor.
+ * Sizes are rounded up to MIN_ALIGNMENT so the cursor stays aligned, a stricter alignment (or an odd extra)
+ * reserves the worst case padding in the same fetch-add.
+ * An allocation that does not fit returns nullptr and leaves the cursor past the end, every later one fails too
+ * until rewind()/reset(), which like getCurrent() must only be called when no thread is allocating.
+ *
+ * With a chunk size set, each thread carves its small allocations from a chunk it grabbed from the shared
+ * buffer, so most allocations touch no shared cache line at all. Near the end of the buffer a chunk is cut
+ * down to the bytes left. The chunks of all threads are dropped by rewind()/reset(), the unused tail of a chunk is wasted.
+ */
+class GConcurrentLinearAllocator
+{
+public:
+    static constexpr size_t MIN_ALIGNMENT = alignof(std::max_align_t);
+
+public:
+    GConcurrentLinearAllocator() = default;
+
+    /**
+     * @param begin
+     * @param end
+     * @param chunkSize Size of the per-thread chunks, 0 to always allocate from the shared cursor
+     */
+    GConcurrentLinearAllocator(void *begin, void *end, size_t chunkSize = 0) noexcept
+            : mBegin(static_cast<char *>(begin)),
+              mSize(reinterpret_cast<uintptr_t>(end) - reinterpret_cast<uintptr_t>(begin)),
+              mChunkSize(pointer::alignSize(chunkSize, MIN_ALIGNMENT)),
+              mGeneration(nextGeneration())
+    {
+        // The cursor is kept aligned relative to the buffer start
+        GX_ASSERT(reinterpret_cast<uintptr_t>(begin) % MIN_ALIGNMENT == 0);
+    }
+
+    template<typename AREA>
+    explicit GConcurrentLinearAllocator(const AREA &area, size_t chunkSize = 0)
+            : GConcurrentLinearAllocator(area.begin(), area.end(), chunkSize)
+    {}
+
+    GConcurrentLinearAllocator(const GConcurrentLinearAllocator &rhs) = delete;
+
+    GConcurrentLinearAllocator &operator=(const GConcurrentLinearAllocator &rhs) = delete;
+
+    GConcurrentLinearAllocator(GConcurrentLinearAllocator &&rhs) noexcept
+    {
+        this->swap(rhs);
+    }
+
+    GConcurrentLinearAllocator &operator=(GConcurrentLinearAllocator &&rhs) noexcept
+    {
+        if (this != &rhs) {
+            this->swap(rhs);
+        }
+        return *this;
+    }
+
+    ~GConcurrentLinearAllocator() noexcept = default;
+
+public:
+    void *alloc(size_t size, size_t alignment = alignof(std::max_align_t), size_t extra = 0)
+    {
+        if (mChunkSize && size + extra <= mChunkSize / 4 && alignment <= MIN_ALIGNMENT) {
+            return allocLocal(size, alignment, extra);
+        }
+        return allocShared(size, alignment, extra);
+    }
+
+    void *getCurrent() noexcept
+    {
+        return mBegin + std::min(mCur.load(std::memory_order_relaxed), mSize);
+    }
+
+    /**
+     * @brief Roll back to a marker returned by getCurrent(), no thread may be allocating
+     * @param p
+     */
+    void rewind(void *p) noexcept
+    {
+        GX_ASSERT(p >= mBegin && p <= mBegin + mSize);
+        mCur.store(static_cast<size_t>(static_cast<char *>(p) - mBegin), std::memory_order_relaxed);
+        // Invalidates the chunks cached by the threads
+        mGeneration = nextGeneration();
+    }
+
+    void reset() noexcept
+    {
+        rewind(mBegin);
+    }
+
+    size_t size() const noexcept
+    {
+        return std::min(mCur.load(std::memory_order_relaxed), mSize);
+    }
+
+    size_t capacity() const noexcept
+    {
+        return mSize;
+    }
+
+    void swap(GConcurrentLinearAllocator &rhs) noexcept
+    {
+        std::swap(mBegin, rhs.mBegin);
+        std::swap(mSize, rhs.mSize);
+        std::swap(mChunkSize, rhs.mChunkSize);
+        const size_t cur = mCur.load(std::memory_order_relaxed);
+        mCur.store(rhs.mCur.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        rhs.mCur.store(cur, std::memory_order_relaxed);
+        mGeneration = nextGeneration();
+        rhs.mGeneration = nextGeneration();
+    }
+
+    void *base() noexcept
+    { return mBegin; }
+
+    void free(void *) noexcept
+    {}
+
+    void free(void *, size_t) noexcept
+    {}
+
+private:
+    struct LocalChunk
+    {
+        uint64_t generation = 0;
+        char *cur = nullptr;
+        char *end = nullptr;
+    };
+
+    static constexpr size_t LOCAL_CHUNK_SLOTS = 4;
+
+    void *allocShared(size_t size, size_t alignment, size_t extra) noexcept
+    {
+        // The cursor is MIN_ALIGNMENT aligned, only a stricter alignment or an odd extra needs padding
+        const bool aligned = alignment <= MIN_ALIGNMENT && extra % alignment == 0;
+        const size_t padding = aligned ? 0 : alignment - 1;
+        const size_t reserve = pointer::alignSize(size + extra + padding, MIN_ALIGNMENT);
+        const size_t offset = mCur.fetch_add(reserve, std::memory_order_relaxed);
+        if (offset + reserve > mSize) {
+            return nullptr;
+        }
+        return pointer::align(mBegin + offset, alignment, extra);
+    }
+
+    void *allocLocal(size_t size, size_t alignment, size_t extra) noexcept
+    {
+        LocalChunk &chunk = localChunk();
+        if (chunk.cur) {
+            char *const p = pointer::align(chunk.cur, alignment, extra);
+            if (p + size <= chunk.end) {
+                chunk.cur = p + size;
+                return p;
+            }
+        }
+        // Unlike allocShared() the cursor must not be pushed past the end, the tail of the buffer makes a smaller chunk
+        size_t offset = mCur.load(std::memory_order_relaxed);
+        size_t take;
+        do {
+            if (offset >= mSize) {
+                return nullptr;
+            }
+            take = std::min(mChunkSize, mSize - offset);
+        } while (!mCur.compare_exchange_weak(offset, offset + take, std::memory_order_relaxed));
+
+        chunk.cur = mBegin + offset;
+        chunk.end = chunk.cur + take;
+        char *const p = pointer::align(chunk.cur, alignment, extra);
+        if (p + size > chunk.end) {
+            return nullptr;
+        }
+        chunk.cur = p + size;
+        return p;
+    }
+
+    /**
+     * @brief Chunk of the calling thread for this allocator,
+     * a thread keeps chunks of up to LOCAL_CHUNK_SLOTS allocators at a time
+     */
+    LocalChunk &localChunk() noexcept
+    {
+        thread_local LocalChunk chunks[LOCAL_CHUNK_SLOTS];
+        thread_local size_t victim = 0;
+        for (auto &chunk: chunks) {
+            if (chunk.generation == mGeneration) {
+                return chunk;
+            }
+        }
+        LocalChunk &chunk = chunks[victim++ % LOCAL_CHUNK_SLOTS];
+        chunk = LocalChunk{mGeneration, nullptr, nullptr};
+        return chunk;
+    }
+
+    /**
+     * @brief Unique across allocators and across their rewinds, tags the thread local chunks
+     */
+    static uint64_t nextGeneration() noexcept
+    {
+        static std::atomic<uint64_t> sGeneration{0};
+        return sGeneration.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+private:
+    char *mBegin = nullptr;
+    size_t mSize = 0;
+    size_t mChunkSize = 0;
+    alignas(GX_CACHE_LINE_SIZE) std::atomic<size_t> mCur{0};
+    uint64_t mGeneration = 0;
 };
 
 
@@ -250,28 +724,46 @@ public:
 
 // ------------------------------------------------------------------------------------------------
 
+/**
+ * @class GFreeList
+ * @brief Intrusive list of fixed size nodes.
+ * The nodes come from the user buffer first, then they are carved contiguously from slabs
+ * (slabSize rounded up to a power of two and aligned to it) instead of one allocation per node.
+ * clear() releases the slabs whose nodes are all free. With maxEmptySlabs set, push() also
+ * releases them once more than maxEmptySlabs slabs are completely free and they hold at least half of the free nodes.
+ */
 class GFreeList
 {
+public:
+    static constexpr size_t DEFAULT_SLAB_SIZE = 4096;
+    static constexpr size_t NO_EMPTY_SLAB_LIMIT = SIZE_MAX;
+
 public:
     GFreeList() noexcept = delete;
 
-    GFreeList(void *begin, void *end, size_t elementSize, size_t alignment, size_t extra) noexcept
+    GFreeList(void *begin, void *end, size_t elementSize, size_t alignment, size_t extra,
+              size_t slabSize = DEFAULT_SLAB_SIZE, size_t maxEmptySlabs = NO_EMPTY_SLAB_LIMIT) noexcept
             : mElementSize(elementSize),
               mAlignment(alignment),
-              mHead(init(begin, end, elementSize, alignment, extra)),
+              mExtra(extra),
+              mSlabSize(slabSizeFor(elementSize, alignment, extra, slabSize)),
+              mMaxEmptySlabs(maxEmptySlabs),
               mUserBegin(begin),
               mUserEnd(end)
     {
-        size_t nodeCount = 0;
-        for (const Node *c = mHead; c != nullptr; c = c->next) {
-            ++nodeCount;
+        if (begin != end) {
+            size_t nodeCount = 0;
+            mHead = carve(begin, end, elementSize, alignment, extra, nodeCount);
+            mCapacity = nodeCount * mElementSize;
         }
-        mCapacity = nodeCount * mElementSize;
     }
 
-    GFreeList(size_t elementSize, size_t alignment) noexcept
+    GFreeList(size_t elementSize, size_t alignment,
+              size_t slabSize = DEFAULT_SLAB_SIZE, size_t maxEmptySlabs = NO_EMPTY_SLAB_LIMIT) noexcept
             : mElementSize(elementSize),
-              mAlignment(alignment)
+              mAlignment(alignment),
+              mSlabSize(slabSizeFor(elementSize, alignment, 0, slabSize)),
+              mMaxEmptySlabs(maxEmptySlabs)
     {
     }
 
@@ -284,23 +776,57 @@ public:
 
     GFreeList &operator=(const GFreeList &rhs) = delete;
 
-    GFreeList(GFreeList &&rhs) noexcept = default;
+    GFreeList(GFreeList &&rhs) noexcept
+            : mElementSize(rhs.mElementSize),
+              mAlignment(rhs.mAlignment),
+              mExtra(rhs.mExtra),
+              mSlabSize(rhs.mSlabSize),
+              mMaxEmptySlabs(rhs.mMaxEmptySlabs),
+              mHead(std::exchange(rhs.mHead, nullptr)),
+              mSlabs(std::exchange(rhs.mSlabs, nullptr)),
+              mUserBegin(std::exchange(rhs.mUserBegin, nullptr)),
+              mUserEnd(std::exchange(rhs.mUserEnd, nullptr)),
+              mAllocCount(std::exchange(rhs.mAllocCount, 0)),
+              mCapacity(std::exchange(rhs.mCapacity, 0)),
+              mEmptySlabs(std::exchange(rhs.mEmptySlabs, 0)),
+              mSlabNodeCount(rhs.mSlabNodeCount)
+    {
+    }
 
-    GFreeList &operator=(GFreeList &&rhs) noexcept = default;
+    GFreeList &operator=(GFreeList &&rhs) noexcept
+    {
+        if (this != &rhs) {
+            std::swap(mElementSize, rhs.mElementSize);
+            std::swap(mAlignment, rhs.mAlignment);
+            std::swap(mExtra, rhs.mExtra);
+            std::swap(mSlabSize, rhs.mSlabSize);
+            std::swap(mMaxEmptySlabs, rhs.mMaxEmptySlabs);
+            std::swap(mHead, rhs.mHead);
+            std::swap(mSlabs, rhs.mSlabs);
+            std::swap(mUserBegin, rhs.mUserBegin);
+            std::swap(mUserEnd, rhs.mUserEnd);
+            std::swap(mAllocCount, rhs.mAllocCount);
+            std::swap(mCapacity, rhs.mCapacity);
+            std::swap(mEmptySlabs, rhs.mEmptySlabs);
+            std::swap(mSlabNodeCount, rhs.mSlabNodeCount);
+        }
+        return *this;
+    }
 
 public:
     void *pop() noexcept
     {
         if (mHead == nullptr) {
-            Node *const head = createNode();
-            CHECK_CONDITION_R(head, nullptr);
-            head->next = nullptr;
-            mHead = head;
-            mCapacity += mElementSize;
+            CHECK_CONDITION_R(grow(), nullptr);
         }
         Node *const head = mHead;
-        mHead = (head ? head->next : nullptr);
+        mHead = head->next;
         ++mAllocCount;
+        if (mMaxEmptySlabs != NO_EMPTY_SLAB_LIMIT && !isUserNode(head)) {
+            if (slabOf(head)->used++ == 0) {
+                --mEmptySlabs;
+            }
+        }
         return head;
     }
 
@@ -311,6 +837,11 @@ public:
         head->next = mHead;
         mHead = head;
         --mAllocCount;
+        if (mMaxEmptySlabs != NO_EMPTY_SLAB_LIMIT && !isUserNode(head)) {
+            if (--slabOf(head)->used == 0 && ++mEmptySlabs > mMaxEmptySlabs && emptySlabsDominate()) {
+                releaseEmptySlabs();
+            }
+        }
     }
 
     void *getFirst() noexcept
@@ -318,21 +849,25 @@ public:
         return mHead;
     }
 
+    /**
+     * @brief Release the slabs with no allocated node, the user buffer is kept
+     */
     void clear() noexcept
     {
-        Node *userNodeHead = nullptr;
-        while (mHead) {
-            Node *next = mHead->next;
-            if (mHead >= mUserBegin && mHead < mUserEnd) {
-                mHead->next = userNodeHead;
-                userNodeHead = mHead;
-            } else {
-                gx::alignedFree(mHead);
-                mCapacity -= mElementSize;
+        // Recount from the free nodes, the used counts are only maintained with an empty slab limit
+        for (Slab *slab = mSlabs; slab; slab = slab->next) {
+            slab->freeCount = 0;
+        }
+        for (const Node *node = mHead; node; node = node->next) {
+            if (!isUserNode(node)) {
+                ++slabOf(node)->freeCount;
             }
-            mHead = next;
         }
-        mHead = userNodeHead;
+        for (Slab *slab = mSlabs; slab; slab = slab->next) {
+            slab->used = slab->nodeCount - slab->freeCount;
+            slab->freeCount = 0;
+        }
+        releaseEmptySlabs();
     }
 
     size_t size() const noexcept
@@ -345,13 +880,39 @@ public:
         return mCapacity;
     }
 
+    size_t slabCount() const noexcept
+    {
+        size_t count = 0;
+        for (const Slab *slab = mSlabs; slab; slab = slab->next) {
+            ++count;
+        }
+        return count;
+    }
+
 private:
     struct Node
     {
         Node *next;
     };
 
-    static Node *init(void *begin, void *end, size_t elementSize, size_t alignment, size_t extra) noexcept
+    struct Slab
+    {
+        Slab *prev;
+        Slab *next;
+        size_t nodeCount;
+        size_t used;        // Only kept up to date with an empty slab limit
+        size_t freeCount;   // Scratch for releaseEmptySlabs()
+    };
+
+    static size_t slabSizeFor(size_t elementSize, size_t alignment, size_t extra, size_t slabSize) noexcept
+    {
+        // Room for the header and a few nodes whatever the padding
+        const size_t minSize = sizeof(Slab) + extra + alignment + 4 * (elementSize + alignment);
+        return std::bit_ceil(std::max(slabSize, minSize));
+    }
+
+    static Node *carve(void *begin, void *end, size_t elementSize, size_t alignment, size_t extra,
+                       size_t &nodeCount) noexcept
     {
         void *const p = pointer::align(begin, alignment, extra);
         void *const n = pointer::align(pointer::add(p, elementSize), alignment, extra);
@@ -372,22 +933,94 @@ private:
         GX_ASSERT(cur < end);
         GX_ASSERT(pointer::add(cur, d) <= end);
         cur->next = nullptr;
+        nodeCount = num;
         return head;
     }
 
-    Node *createNode() const noexcept
+    bool grow() noexcept
     {
-        return static_cast<Node *>(gx::alignedAlloc(mElementSize, mAlignment));
+        auto *const slab = static_cast<Slab *>(gx::alignedAlloc(mSlabSize, mSlabSize));
+        if (!slab) {
+            return false;
+        }
+        size_t nodeCount = 0;
+        mHead = carve(slab + 1, pointer::add(slab, mSlabSize), mElementSize, mAlignment, mExtra, nodeCount);
+        slab->prev = nullptr;
+        slab->next = mSlabs;
+        slab->nodeCount = nodeCount;
+        slab->used = 0;
+        slab->freeCount = 0;
+        if (mSlabs) {
+            mSlabs->prev = slab;
+        }
+        mSlabs = slab;
+        mSlabNodeCount = nodeCount;
+        mCapacity += nodeCount * mElementSize;
+        ++mEmptySlabs;
+        return true;
+    }
+
+    /**
+     * @brief Unlink the nodes of the slabs with no allocated node and free those slabs,
+     * relies on the used counts and on freeCount being zero
+     */
+    void releaseEmptySlabs() noexcept
+    {
+        Node **link = &mHead;
+        while (*link) {
+            Node *const node = *link;
+            if (isUserNode(node) || slabOf(node)->used != 0) {
+                link = &node->next;
+                continue;
+            }
+            *link = node->next;
+            Slab *const slab = slabOf(node);
+            // The last node of the slab is off the list
+            if (++slab->freeCount == slab->nodeCount) {
+                (slab->prev ? slab->prev->next : mSlabs) = slab->next;
+                if (slab->next) {
+                    slab->next->prev = slab->prev;
+                }
+                mCapacity -= slab->nodeCount * mElementSize;
+                gx::alignedFree(slab);
+            }
+        }
+        mEmptySlabs = 0;
+    }
+
+    /**
+     * @brief The release walks the whole free list, it only pays off when at least half of the free nodes go away
+     */
+    bool emptySlabsDominate() const noexcept
+    {
+        const size_t freeNodes = mCapacity / mElementSize - mAllocCount;
+        return mEmptySlabs * mSlabNodeCount * 2 >= freeNodes;
+    }
+
+    bool isUserNode(const void *p) const noexcept
+    {
+        return p >= mUserBegin && p < mUserEnd;
+    }
+
+    Slab *slabOf(const void *p) const noexcept
+    {
+        return reinterpret_cast<Slab *>(reinterpret_cast<uintptr_t>(p) & ~(mSlabSize - 1));
     }
 
 private:
     size_t mElementSize = 0;
     size_t mAlignment = 0;
+    size_t mExtra = 0;
+    size_t mSlabSize = 0;
+    size_t mMaxEmptySlabs = NO_EMPTY_SLAB_LIMIT;
     Node *mHead = nullptr;
+    Slab *mSlabs = nullptr;
     void *mUserBegin = nullptr;
     void *mUserEnd = nullptr;
     size_t mAllocCount = 0;
     size_t mCapacity = 0;
+    size_t mEmptySlabs = 0;
+    size_t mSlabNodeCount = 0;
 };
 
 // ------------------------------------------------------------------------------------------------
@@ -398,8 +1031,8 @@ private:
  * For memory pool allocation of fixed large and small blocks,
  * Only memory within a fixed size can be allocated at a time,
  * A certain size of continuous memory can be pre allocated as the initial memory block of the pool,
- * The default FreeList will allocate more memory after the original memory block is exhausted,
- * These memory that has not been allocated can be reclaimed using reset, and will also be reclaimed during PoolAllocator deconstruction,
+ * The default FreeList will allocate more memory in slabs after the original memory block is exhausted,
+ * The slabs with no allocated element can be reclaimed using reset, and will also be reclaimed during PoolAllocator deconstruction,
  * Before disassembling PoolAllocator, it is important to free all allocated memory blocks, otherwise it will cause memory leakage
  *
  * @tparam ELEMENT_SIZE Element size (byte) must be greater than or equal to sizeof (void *)
@@ -421,14 +1054,27 @@ public:
     {
     }
 
-    GPoolAllocator(void *begin, void *end) noexcept
-            : mFreeList(begin, end, ELEMENT_SIZE, ALIGNMENT, OFFSET)
+    /**
+     * @param slabSize      Bytes carved at once when the pool runs dry, rounded up to a power of two
+     * @param maxEmptySlabs Completely free slabs kept before they are returned to the system
+     */
+    explicit GPoolAllocator(size_t slabSize, size_t maxEmptySlabs = GFreeList::NO_EMPTY_SLAB_LIMIT) noexcept
+            : mFreeList(ELEMENT_SIZE, ALIGNMENT, slabSize, maxEmptySlabs)
+    {
+    }
+
+    GPoolAllocator(void *begin, void *end,
+                   size_t slabSize = GFreeList::DEFAULT_SLAB_SIZE,
+                   size_t maxEmptySlabs = GFreeList::NO_EMPTY_SLAB_LIMIT) noexcept
+            : mFreeList(begin, end, ELEMENT_SIZE, ALIGNMENT, OFFSET, slabSize, maxEmptySlabs)
     {
     }
 
     template<typename AREA>
-    explicit GPoolAllocator(const AREA &area) noexcept
-            : GPoolAllocator(area.begin(), area.end())
+    explicit GPoolAllocator(const AREA &area,
+                            size_t slabSize = GFreeList::DEFAULT_SLAB_SIZE,
+                            size_t maxEmptySlabs = GFreeList::NO_EMPTY_SLAB_LIMIT) noexcept
+            : GPoolAllocator(area.begin(), area.end(), slabSize, maxEmptySlabs)
     {
     }
 
@@ -467,6 +1113,11 @@ public:
         return mFreeList.capacity();
     }
 
+    size_t slabCount() const noexcept
+    {
+        return mFreeList.slabCount();
+    }
+
     void *getCurrent() noexcept
     {
         return mFreeList.getFirst();
@@ -481,8 +1132,21 @@ private:
     GFreeList mFreeList;
 };
 
-template<typename T, size_t ALIGNMENT = alignof(T), size_t OFFSET = 0>
-using ObjectPoolAllocator = GPoolAllocator<sizeof(T), ALIGNMENT, OFFSET>;
+template<typename T, size_t ALIGNMENT = alignof(T), size_t OFFSET = 0>
+using ObjectPoolAllocator = GPoolAllocator<sizeof(T), ALIGNMENT, OFFSET>;
+
+/**
+ * Allocators serving blocks of a single size, an arena over them cannot hand out blocks larger than that.
+ */
+template<typename ALLOCATOR>
+struct GIsFixedSizeAllocator : std::false_type
+{
+};
+
+template<size_t ELEMENT_SIZE, size_t ALIGNMENT, size_t OFFSET>
+struct GIsFixedSizeAllocator<GPoolAllocator<ELEMENT_SIZE, ALIGNMENT, OFFSET>> : std::true_type
+{
+};
 
 // ------------------------------------------------------------------------------------------------
 // Areas
@@ -584,6 +1248,119 @@ private:
     void *mEnd = nullptr;
 };
 
+/**
+ * @class GMmapArea
+ * @brief Area mapped straight from the system, for large pools and scratch arenas.
+ *
+ * The whole size is reserved at once, pages are only backed on first touch (or on commit()),
+ * so a large reservation costs nothing until it is used and its addresses never move while it grows.
+ * commit() pre-faults the front of the area ahead of the hot path, with populate the whole area is
+ * faulted in by the constructor. Huge pages cut the TLB misses, Explicit uses the reserved huge page pool
+ * (MAP_HUGETLB) and falls back to Transparent (MADV_HUGEPAGE) when it is empty.
+ * numaNode is a preferred placement hint (mbind), it has to be given before the pages are touched.
+ * The options that a platform does not support are ignored.
+ *
+ * On Windows the whole size is reserved and committed at once (MEM_RESERVE | MEM_COMMIT). The pages are still
+ * only backed on first touch, but the area is charged against the system commit limit from the start, so a
+ * large reservation can fail there while it would succeed on Linux. The allocators write anywhere in the
+ * area without telling it, so it cannot commit on first use.
+ */
+class GX_API GMmapArea
+{
+public:
+    enum class HugePages
+    {
+        None,
+        Transparent,
+        Explicit,
+    };
+
+    struct Options
+    {
+        HugePages hugePages = HugePages::None;
+        bool populate = false;      ///< Fault the whole area in at construction
+        size_t commitSize = 0;      ///< Bytes faulted in at construction when not populating
+        int32_t numaNode = -1;      ///< Preferred NUMA node, -1 for the default policy
+    };
+
+public:
+    GMmapArea() noexcept = default;
+
+    explicit GMmapArea(size_t size)
+            : GMmapArea(size, Options())
+    {
+    }
+
+    GMmapArea(size_t size, const Options &options);
+
+    ~GMmapArea() noexcept;
+
+    GMmapArea(const GMmapArea &rhs) = delete;
+
+    GMmapArea &operator=(const GMmapArea &rhs) = delete;
+
+    GMmapArea(GMmapArea &&rhs) noexcept
+    {
+        swap(*this, rhs);
+    }
+
+    GMmapArea &operator=(GMmapArea &&rhs) noexcept
+    {
+        if (this != &rhs) {
+            swap(*this, rhs);
+        }
+        return *this;
+    }
+
+public:
+    void *data() const noexcept
+    { return mBegin; }
+
+    void *begin() const noexcept
+    { return mBegin; }
+
+    void *end() const noexcept
+    { return mEnd; }
+
+    size_t size() const noexcept
+    { return uintptr_t(mEnd) - uintptr_t(mBegin); }
+
+    /**
+     * @brief Fault in the pages of the first bytes of the area, the committed part only grows.
+     * The content is left untouched, it is safe to call while the area is in use.
+     * @param bytes
+     */
+    void commit(size_t bytes) noexcept;
+
+    size_t committed() const noexcept
+    { return mCommitted; }
+
+    /**
+     * @return Whether the area is backed by huge pages (explicit or transparent)
+     */
+    bool isHugePages() const noexcept
+    { return mHugePages; }
+
+    friend void swap(GMmapArea &lhs, GMmapArea &rhs) noexcept
+    {
+        using std::swap;
+        swap(lhs.mBegin, rhs.mBegin);
+        swap(lhs.mEnd, rhs.mEnd);
+        swap(lhs.mMapping, rhs.mMapping);
+        swap(lhs.mMappingSize, rhs.mMappingSize);
+        swap(lhs.mCommitted, rhs.mCommitted);
+        swap(lhs.mHugePages, rhs.mHugePages);
+    }
+
+private:
+    void *mBegin = nullptr;
+    void *mEnd = nullptr;
+    void *mMapping = nullptr;       // What was mapped, may be larger than the area for alignment
+    size_t mMappingSize = 0;
+    size_t mCommitted = 0;
+    bool mHugePages = false;
+};
+
 class GNullArea
 {
 public:
@@ -607,9 +1384,324 @@ using Mutex = GMutex;
 
 using SpinLock = GSpinLock;
 
+using Adaptive = GAdaptiveLock;
+
 } // namespace LockingPolicy
 
 
+// ------------------------------------------------------------------------------------------------
+// Tracking
+// ------------------------------------------------------------------------------------------------
+
+struct GArenaStats
+{
+    const char *name = nullptr;
+    size_t currentBytes = 0;    ///< Bytes requested and not freed yet
+    size_t peakBytes = 0;       ///< High watermark of currentBytes
+    uint64_t allocCount = 0;
+    uint64_t freeCount = 0;
+    uint64_t failedAllocs = 0;  ///< Requests the allocator returned nullptr for
+};
+
+/**
+ * @class GArenaTracker
+ * @brief Usage counters of an arena, shared by the tracking policies.
+ * The counters are atomics so that arenas using GLockingPolicy::NoLock from several threads stay exact,
+ * each tracker registers itself to GArenaRegistry for its lifetime.
+ */
+class GX_API GArenaTracker
+{
+public:
+    explicit GArenaTracker(const char *name) noexcept;
+
+    ~GArenaTracker() noexcept;
+
+    GArenaTracker(const GArenaTracker &) = delete;
+
+    GArenaTracker &operator=(const GArenaTracker &) = delete;
+
+public:
+    GArenaStats stats() const noexcept;
+
+    void onAlloc(void *p, size_t size) noexcept
+    {
+        if (!p) {
+            mFailedAllocs.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        mAllocCount.fetch_add(1, std::memory_order_relaxed);
+        const size_t current = mCurrentBytes.fetch_add(size, std::memory_order_relaxed) + size;
+        size_t peak = mPeakBytes.load(std::memory_order_relaxed);
+        while (current > peak && !mPeakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+        }
+    }
+
+    void onFree(size_t size) noexcept
+    {
+        mFreeCount.fetch_add(1, std::memory_order_relaxed);
+        mCurrentBytes.fetch_sub(size, std::memory_order_relaxed);
+    }
+
+    void setCurrentBytes(size_t bytes) noexcept
+    {
+        mCurrentBytes.store(bytes, std::memory_order_relaxed);
+    }
+
+    void swapCounters(GArenaTracker &rhs) noexcept;
+
+private:
+    friend class GArenaRegistry;
+
+    const char *mName;
+    std::atomic<size_t> mCurrentBytes{0};
+    std::atomic<size_t> mPeakBytes{0};
+    std::atomic<uint64_t> mAllocCount{0};
+    std::atomic<uint64_t> mFreeCount{0};
+    std::atomic<uint64_t> mFailedAllocs{0};
+    size_t mRegistryIndex = 0;  // Position in the registry, guarded by its lock
+};
+
+/**
+ * @class GArenaRegistry
+ * @brief Process wide list of the tracked arenas
+ */
+class GX_API GArenaRegistry
+{
+public:
+    static std::vector<GArenaStats> snapshot();
+
+    /**
+     * @brief Log the statistics of every tracked arena
+     */
+    static void dump();
+
+private:
+    friend class GArenaTracker;
+
+    static void add(GArenaTracker *tracker);
+
+    static void remove(GArenaTracker *tracker);
+};
+
+/**
+ * The tracking policies are notified by GArena after each allocator call, under the arena lock.
+ * Untracked compiles to nothing.
+ */
+namespace GTrackingPolicy
+{
+
+class Untracked
+{
+public:
+    static constexpr bool ENABLED = false;
+
+    explicit Untracked(const char *) noexcept
+    {}
+
+    void onAlloc(void *, size_t, size_t, size_t) noexcept
+    {}
+
+    void onFree(void *) noexcept
+    {}
+
+    void onFree(void *, size_t) noexcept
+    {}
+
+    void onReset() noexcept
+    {}
+
+    void onMarker(void *) noexcept
+    {}
+
+    void onRewind(void *, size_t) noexcept
+    {}
+
+    GArenaStats stats() const noexcept
+    { return {}; }
+
+    friend void swap(Untracked &, Untracked &) noexcept
+    {}
+};
+
+/**
+ * Counts requested bytes, the high watermark, allocations, frees and failures.
+ * The size of a free must be known, GArena::free(p) without a size does not compile, use GTrackingPolicy::Full for it.
+ * rewind() resyncs the current bytes with the allocator size().
+ */
+class Counters
+{
+public:
+    static constexpr bool ENABLED = true;
+
+    explicit Counters(const char *name) noexcept
+            : mTracker(name)
+    {}
+
+    void onAlloc(void *p, size_t size, size_t, size_t) noexcept
+    {
+        mTracker.onAlloc(p, size);
+    }
+
+    /**
+     * @brief The current bytes would never go down, see GTrackingPolicy::Full
+     */
+    void onFree(void *) noexcept = delete;
+
+    void onFree(void *, size_t size) noexcept
+    {
+        mTracker.onFree(size);
+    }
+
+    void onReset() noexcept
+    {
+        mTracker.setCurrentBytes(0);
+    }
+
+    void onMarker(void *) noexcept
+    {}
+
+    void onRewind(void *, size_t allocatorSize) noexcept
+    {
+        mTracker.setCurrentBytes(allocatorSize);
+    }
+
+    GArenaStats stats() const noexcept
+    { return mTracker.stats(); }
+
+    friend void swap(Counters &lhs, Counters &rhs) noexcept
+    {
+        lhs.mTracker.swapCounters(rhs.mTracker);
+    }
+
+private:
+    GArenaTracker mTracker;
+};
+
+/**
+ * Counters plus a record of every live allocation, so unsized frees and rewinds are exact,
+ * the allocations still alive when the arena is destroyed are reported as leaks.
+ * The allocations are kept in allocation order, a rewind drops those made after GArena::getCurrent()
+ * returned the marker, wherever the allocator placed them (the blocks of GChainedLinearAllocator are not address ordered).
+ */
+class Full
+{
+public:
+    static constexpr bool ENABLED = true;
+
+    explicit Full(const char *name) noexcept
+            : mTracker(name)
+    {}
+
+    ~Full() noexcept
+    {
+        if (!mLive.empty()) {
+            size_t bytes = 0;
+            for (const auto &it: mLive) {
+                bytes += it.second.size;
+            }
+            LogW("Arena \"{}\" destroyed with {} live allocations ({} bytes)",
+                 mTracker.stats().name, mLive.size(), bytes);
+        }
+    }
+
+    void onAlloc(void *p, size_t size, size_t, size_t) noexcept
+    {
+        mTracker.onAlloc(p, size);
+        if (p) {
+            GLockerGuard locker(mLock);
+            const uint64_t sequence = mNextSequence++;
+            mLive[sequence] = Live{reinterpret_cast<uintptr_t>(p), size};
+            mSequences[reinterpret_cast<uintptr_t>(p)] = sequence;
+        }
+    }
+
+    void onFree(void *p) noexcept
+    {
+        size_t size = 0;
+        {
+            GLockerGuard locker(mLock);
+            const auto it = mSequences.find(reinterpret_cast<uintptr_t>(p));
+            GX_ASSERT_S(it != mSequences.end(), "Arena \"{}\" frees an unknown pointer", mTracker.stats().name);
+            if (it != mSequences.end()) {
+                const auto live = mLive.find(it->second);
+                size = live->second.size;
+                mLive.erase(live);
+                mSequences.erase(it);
+            }
+        }
+        mTracker.onFree(size);
+    }
+
+    void onFree(void *p, size_t) noexcept
+    {
+        onFree(p);
+    }
+
+    void onReset() noexcept
+    {
+        GLockerGuard locker(mLock);
+        mLive.clear();
+        mSequences.clear();
+        mMarkers.clear();
+        mTracker.setCurrentBytes(0);
+    }
+
+    void onMarker(void *marker) noexcept
+    {
+        GLockerGuard locker(mLock);
+        mMarkers[reinterpret_cast<uintptr_t>(marker)] = mNextSequence;
+    }
+
+    void onRewind(void *addr, size_t) noexcept
+    {
+        GLockerGuard locker(mLock);
+        const auto marker = mMarkers.find(reinterpret_cast<uintptr_t>(addr));
+        GX_ASSERT_S(marker != mMarkers.end(), "Arena \"{}\" rewinds to a marker not taken by getCurrent()", mTracker.stats().name);
+        const uint64_t sequence = marker != mMarkers.end() ? marker->second : mNextSequence;
+        for (auto it = mLive.lower_bound(sequence); it != mLive.end(); it = mLive.erase(it)) {
+            mSequences.erase(it->second.addr);
+        }
+        // The markers taken after this one point into the released range
+        for (auto it = mMarkers.begin(); it != mMarkers.end();) {
+            it = it->second > sequence ? mMarkers.erase(it) : std::next(it);
+        }
+        size_t bytes = 0;
+        for (const auto &it: mLive) {
+            bytes += it.second.size;
+        }
+        mTracker.setCurrentBytes(bytes);
+    }
+
+    GArenaStats stats() const noexcept
+    { return mTracker.stats(); }
+
+    friend void swap(Full &lhs, Full &rhs) noexcept
+    {
+        lhs.mTracker.swapCounters(rhs.mTracker);
+        std::swap(lhs.mLive, rhs.mLive);
+        std::swap(lhs.mSequences, rhs.mSequences);
+        std::swap(lhs.mMarkers, rhs.mMarkers);
+        std::swap(lhs.mNextSequence, rhs.mNextSequence);
+    }
+
+private:
+    struct Live
+    {
+        uintptr_t addr;
+        size_t size;
+    };
+
+    GArenaTracker mTracker;
+    GSpinLock mLock;
+    uint64_t mNextSequence = 0;
+    std::map<uint64_t, Live> mLive;                     ///< By allocation sequence
+    std::unordered_map<uintptr_t, uint64_t> mSequences; ///< Sequence of each live address
+    std::unordered_map<uintptr_t, uint64_t> mMarkers;   ///< Sequence at which each marker was taken
+};
+
+} // namespace GTrackingPolicy
+
+
 // ------------------------------------------------------------------------------------------------
 // Arenas
 // ------------------------------------------------------------------------------------------------
@@ -619,12 +1711,51 @@ using GUniquePtrDeleter = std::function<void(void *)>;
 template<typename T>
 using GUniquePtr = std::unique_ptr<T, GUniquePtrDeleter>;
 
-template<typename AllocatorPolicy, typename LockingPolicy, typename AreaPolicy = GHeapArea>
+template<typename TYPE, typename ARENA>
+class GSTLAllocator;
+
+/**
+ * Deleter of the unique pointers made by an arena, a single arena pointer.
+ * Converts to GUniquePtrDeleter, so the pointers still convert to GUniquePtr.
+ */
+template<typename T, typename ARENA>
+class GArenaDeleter
+{
+public:
+    GArenaDeleter() noexcept = default;
+
+    explicit GArenaDeleter(ARENA *arena) noexcept
+            : mArena(arena)
+    {}
+
+    void operator()(T *p) const noexcept
+    {
+        mArena->destroy(p);
+    }
+
+    void operator()(void *p) const noexcept
+    {
+        mArena->destroy(static_cast<T *>(p));
+    }
+
+    ARENA *arena() const noexcept
+    { return mArena; }
+
+private:
+    ARENA *mArena = nullptr;
+};
+
+template<typename T, typename ARENA>
+using GArenaUniquePtr = std::unique_ptr<T, GArenaDeleter<T, ARENA>>;
+
+template<typename AllocatorPolicy, typename LockingPolicy, typename AreaPolicy = GHeapArea,
+        typename TrackingPolicy = GTrackingPolicy::Untracked>
 class GArena
 {
 public:
     explicit GArena(const char *name = "")
-            : mName(name)
+            : mName(name),
+              mTracking(name)
     {
     }
 
@@ -639,7 +1770,8 @@ public:
     GArena(const char *name, size_t size, ARGS &&... args)
             : mArea(size),
               mAllocator(mArea, std::forward<ARGS>(args) ...),
-              mName(name)
+              mName(name),
+              mTracking(name)
     {
     }
 
@@ -647,7 +1779,8 @@ public:
     GArena(const char *name, AreaPolicy &&area, ARGS &&... args)
             : mArea(std::forward<AreaPolicy>(area)),
               mAllocator(mArea, std::forward<ARGS>(args) ...),
-              mName(name)
+              mName(name),
+              mTracking(name)
     {
     }
 
@@ -676,6 +1809,7 @@ public:
     {
         GLockerGuard guard(mLock);
         void *p = mAllocator.alloc(size, alignment, extra);
+        mTracking.onAlloc(p, size, alignment, extra);
         return p;
     }
 
@@ -704,6 +1838,7 @@ public:
     {
         if (p) {
             GLockerGuard guard(mLock);
+            mTracking.onFree(p);
             mAllocator.free(p);
         }
     }
@@ -717,6 +1852,7 @@ public:
     {
         if (p) {
             GLockerGuard guard(mLock);
+            mTracking.onFree(p, size);
             mAllocator.free(p, size);
         }
     }
@@ -731,15 +1867,21 @@ public:
     {
         GLockerGuard guard(mLock);
         mAllocator.reset();
+        mTracking.onReset();
     }
 
     void *getCurrent() noexcept
-    { return mAllocator.getCurrent(); }
+    {
+        void *const marker = mAllocator.getCurrent();
+        mTracking.onMarker(marker);
+        return marker;
+    }
 
     void rewind(void *addr) noexcept
     {
         GLockerGuard guard(mLock);
         mAllocator.rewind(addr);
+        mTracking.onRewind(addr, mAllocator.size());
     }
 
     size_t size() const noexcept
@@ -786,27 +1928,37 @@ public:
     /**
      * @brief Allocate memory for the specified type and create an object and return shared_ Ptr,
      * the object will automatically destruct and reclaim memory after the reference count is reset to zero.
+     * The control block and the object share a single arena allocation (std::allocate_shared).
+     * Over a fixed size allocator, or for an alignment above alignof(T), the object gets its own block
+     * and the control block goes to the heap.
      * @tparam T
      * @tparam ALIGN
      * @tparam ARGS
      * @param args
-     * @return
+     * @return nullptr if the arena is out of memory
      */
     template<typename T, size_t ALIGN = alignof(T), typename... ARGS>
     std::shared_ptr<T> makeShared(ARGS &&... args) noexcept
     {
-        void *const p = this->alloc(sizeof(T), ALIGN);
-        if (p) {
-            return std::shared_ptr<T>(new(p) T(std::forward<ARGS>(args)...), [this](void *ptr) {
-                destroy(static_cast<T *>(ptr));
-            });
+        if constexpr (ALIGN <= alignof(T) && !GIsFixedSizeAllocator<AllocatorPolicy>::value) {
+            try {
+                return std::allocate_shared<T>(GSTLAllocator<T, GArena>(*this), std::forward<ARGS>(args)...);
+            } catch (const std::bad_alloc &) {
+                return nullptr;
+            }
+        } else {
+            void *const p = this->alloc(sizeof(T), ALIGN);
+            if (p) {
+                return std::shared_ptr<T>(new(p) T(std::forward<ARGS>(args)...), GArenaDeleter<T, GArena>(this));
+            }
+            return nullptr;
         }
-        return nullptr;
     }
 
     /**
      * @brief Allocate memory for the specified type and create an object and return unique_ Ptr,
      * the object will automatically destruct and reclaim memory after being abandoned by the owner.
+     * The deleter only holds the arena pointer.
      * @tparam T
      * @tparam ALIGN
      * @tparam ARGS
@@ -814,21 +1966,23 @@ public:
      * @return
      */
     template<typename T, size_t ALIGN = alignof(T), typename... ARGS>
-    GUniquePtr<T> makeUnique(ARGS &&... args) noexcept
+    GArenaUniquePtr<T, GArena> makeUnique(ARGS &&... args) noexcept
     {
-        void *const p = this->alloc(sizeof(T), ALIGN);
-        if (p) {
-            GUniquePtrDeleter deleter = [this](void *ptr) {
-                destroy(static_cast<T *>(ptr));
-            };
-            return std::unique_ptr<T, GUniquePtrDeleter>(new(p) T(std::forward<ARGS>(args)...), deleter);
-        }
-        return nullptr;
+        return GArenaUniquePtr<T, GArena>(make<T, ALIGN>(std::forward<ARGS>(args)...), GArenaDeleter<T, GArena>(this));
     }
 
     const char *getName() const noexcept
     { return mName; }
 
+    /**
+     * @brief Usage statistics, all zero with GTrackingPolicy::Untracked
+     */
+    GArenaStats stats() const noexcept
+    { return mTracking.stats(); }
+
+    TrackingPolicy &getTracking() noexcept
+    { return mTracking; }
+
     AllocatorPolicy &getAllocator() noexcept
     { return mAllocator; }
 
@@ -848,6 +2002,7 @@ public:
         swap(lhs.mAllocator, rhs.mAllocator);
         swap(lhs.mLock, rhs.mLock);
         swap(lhs.mName, rhs.mName);
+        swap(lhs.mTracking, rhs.mTracking);
     }
 
 private:
@@ -855,12 +2010,22 @@ private:
     AllocatorPolicy mAllocator;
     mutable LockingPolicy mLock;
     const char *mName = nullptr;
+    // Takes no room when untracked
+#if defined(_MSC_VER)
+    [[msvc::no_unique_address]] TrackingPolicy mTracking;
+#else
+    [[no_unique_address]] TrackingPolicy mTracking;
+#endif
 };
 
 // ------------------------------------------------------------------------------------------------
 
 using GHeapArena = GArena<GHeapAllocator, GLockingPolicy::NoLock>;
 
+using GChainedLinearArena = GArena<GChainedLinearAllocator, GLockingPolicy::NoLock, GNullArea>;
+
+using GConcurrentLinearArena = GArena<GConcurrentLinearAllocator, GLockingPolicy::NoLock>;
+
 
 /**
  * Splitter packaging that can be used with STL container translators
@@ -901,7 +2066,11 @@ public:
 public:
     TYPE *allocate(std::size_t n)
     {
-        return static_cast<TYPE *>(mArena.alloc(n * sizeof(TYPE), alignof(TYPE)));
+        void *p = mArena.alloc(n * sizeof(TYPE), alignof(TYPE));
+        if (!p) {
+            throw std::bad_alloc();
+        }
+        return static_cast<TYPE *>(p);
     }
 
     void deallocate(TYPE *p, std::size_t n)
@@ -7,6 +7,7 @@
 
 #include "gobject.h"
 
+#include <functional>
 #include <vector>
 #include <string>
 
@@ -15,10 +16,21 @@ class GAny;
 
 class GString;
 
+class GByteReader;
+
+class GByteWriter;
+
 /**
  * @class GByteArray
  * @brief Byte array class, providing operations such as read and write, HASH calculation,
  * compression and decompression, base64 encoding and decoding for continuous binary data
+ *
+ * Copies share the buffer until one of them writes (copy on write).
+ * A slice is a GByteArray over a range of another one's buffer, made without copying by slice(), readSlice()
+ * and read(GByteArray &), it is promoted to its own buffer holding only its range the first time it is written.
+ * External memory is used without copying either, adopted along with a release callback or borrowed read-only.
+ * The read and write members move the pointers kept in the array, GByteReader and GByteWriter are cursors
+ * with positions of their own, several readers can parse one buffer from different threads.
  */
 class GX_API GByteArray final : public GObject
 {
@@ -29,6 +41,11 @@ public:
         LittleEndian
     };
 
+    /**
+     * @brief Gives adopted memory back to its owner once no GByteArray uses it anymore
+     */
+    using ReleaseFunc = std::function<void(uint8_t *data, int64_t size)>;
+
 public:
     explicit GByteArray(int64_t size = 0);
 
@@ -36,6 +53,22 @@ public:
 
     explicit GByteArray(const std::vector<uint8_t> &data);
 
+    /**
+     * @brief Take over the vector storage without copying
+     * @param data
+     */
+    explicit GByteArray(std::vector<uint8_t> &&data);
+
+    /**
+     * @brief Adopt an external region without copying, such as an mmap'd file, a receive buffer or arena memory.
+     * All size bytes are readable and written in place, growing moves them to a buffer of its own
+     * and hands the region back early.
+     * @param data
+     * @param size
+     * @param release   Called once with data and size
+     */
+    GByteArray(uint8_t *data, int64_t size, ReleaseFunc release);
+
     GByteArray(GByteArray &&other) noexcept;
 
     GByteArray(const GByteArray &other);
@@ -58,11 +91,18 @@ public:
     void reset(int64_t size = 0);
 
     /**
-     * @brief Obtain buffer capacity
+     * @brief Obtain buffer capacity, the range of a slice until it is promoted
      * @return
      */
     int64_t capacity() const;
 
+    /**
+     * @brief Grow the buffer to at least capacity bytes ahead of a series of writes,
+     * the read and write pointers are kept. The bytes past the written range are not initialized.
+     * @param capacity
+     */
+    void reserve(int64_t capacity);
+
     /**
      * @brief Obtain the size of the write range.
      * @return
@@ -167,11 +207,18 @@ public:
     void read(GString &out) const;
 
     /**
-     * @brief Reading a GByteArray
+     * @brief Reading a GByteArray, out becomes a slice of this buffer unless the byte order has to be converted
      * @param out
      */
     void read(GByteArray &out) const;
 
+    /**
+     * @brief Read the next size bytes as a slice of this buffer, raw bytes without byte order conversion
+     * @param size
+     * @return A shorter slice at the end of the data
+     */
+    GByteArray readSlice(int64_t size) const;
+
     /**
      * @brief Read data
      * @param out
@@ -204,7 +251,7 @@ public:
     }
 
     /**
-     * @brief Seek write position
+     * @brief Seek write position, the bytes never written that it brings in range read as zero
      *
      * @param mode SEEK_SET/SEEK_CUR/SEEK_END
      * @param size Positive and negative values represent direction, positive to right, negative to left
@@ -237,6 +284,15 @@ public:
      */
     bool canReadMore() const;
 
+    /**
+     * @brief A GByteArray over the range [pos, pos + length) of the written data, sharing this buffer.
+     * The slice has its own read and write pointers and keeps this byte order.
+     * @param pos
+     * @param length    -1 for the rest of the data
+     * @return
+     */
+    GByteArray slice(int64_t pos, int64_t length = -1) const;
+
     /**
      * @brief Determine whether the content stored in this is the same as that in other
      * @param other
@@ -249,6 +305,15 @@ public:
     std::string toString() const override;
 
 public:
+    /**
+     * @brief Read-only view of memory owned by the caller, which must outlive the result, its copies and its slices.
+     * Nothing is released, the first write moves the data to a buffer of its own.
+     * @param data
+     * @param size
+     * @return
+     */
+    static GByteArray borrow(const uint8_t *data, int64_t size);
+
     /**
      * @brief Parsing data from a string representing hexadecimal
      *
@@ -335,6 +400,13 @@ private:
 
     uint8_t *ptr();
 
+    /**
+     * @brief Set the write position after filling the buffer through ptr(), the bytes count as written
+     */
+    void setWritten(int64_t size);
+
+    bool needsByteOrderConversion() const;
+
     void byteOrder(uint8_t *data, int64_t len) const;
 
     void copyOnWrite();
@@ -343,7 +415,11 @@ private:
 
 private:
     friend class GFile;
+    friend class GByteReader;
+    friend class GByteWriter;
 
+    int64_t mOffset = 0;        // Start of a slice in the shared buffer
+    int64_t mSliceSize = -1;    // Length of the range of a slice, -1 otherwise
     mutable int64_t mWritePos = 0;
     mutable int64_t mReadPos = 0;
     ByteOrder mByteOrder = LittleEndian;
@@ -352,9 +428,14 @@ private:
     {
         uint8_t *buffer = nullptr;
         int64_t size = 0;
+        int64_t initialized = 0;    // Bytes from the start written or zeroed at least once
+        ReleaseFunc release;    // Set for adopted memory, malloc'd otherwise
+        bool borrowed = false;  // Never written nor released
 
         explicit BufferRef(int64_t size);
 
+        BufferRef(uint8_t *buffer, int64_t size, ReleaseFunc release, bool borrowed);
+
         ~BufferRef();
 
         void resize(int64_t newSize);
@@ -363,6 +444,135 @@ private:
     std::shared_ptr<BufferRef> mBufferRef;
 };
 
+
+/**
+ * @class GByteReader
+ * @brief Read cursor over a GByteArray, the position belongs to the reader and the buffer is never modified.
+ * Readers over the same buffer can run on different threads as long as nothing writes to it meanwhile.
+ * The buffer must outlive the reader.
+ */
+class GX_API GByteReader
+{
+public:
+    explicit GByteReader(const GByteArray &buffer, int64_t pos = 0);
+
+public:
+    const GByteArray &buffer() const;
+
+    /**
+     * @brief Read data, byte order converted as the buffer specifies
+     * @param data
+     * @param size
+     * @return Real read size
+     */
+    int64_t read(void *data, int64_t size);
+
+    template<typename Type>
+    void read(Type &out)
+    {
+        read(reinterpret_cast<unsigned char *>(&out), sizeof(Type));
+    }
+
+    void read(std::string &out);
+
+    void read(GString &out);
+
+    /**
+     * @brief Reading a GByteArray, out becomes a slice of the buffer unless the byte order has to be converted
+     * @param out
+     */
+    void read(GByteArray &out);
+
+    /**
+     * @brief Read the next size bytes as a slice of the buffer, raw bytes without byte order conversion
+     * @param size
+     * @return A shorter slice at the end of the data
+     */
+    GByteArray readSlice(int64_t size);
+
+    void read(std::vector<uint8_t> &out);
+
+    void read(GAny &any);
+
+    /**
+     * @brief Seek the read position within the written range of the buffer
+     *
+     * @param mode SEEK_SET/SEEK_CUR/SEEK_END
+     * @param size Positive and negative values represent direction, positive to right, negative to left
+     */
+    void seek(int mode, int64_t size);
+
+    int64_t pos() const;
+
+    /**
+     * @brief Number of bytes left to read
+     * @return
+     */
+    int64_t remaining() const;
+
+    bool canReadMore() const;
+
+private:
+    const GByteArray *mBuffer;
+    int64_t mPos;
+};
+
+
+/**
+ * @class GByteWriter
+ * @brief Write cursor over a GByteArray with a position of its own, starting at the end of the written data.
+ * Writing past the end extends the array, writing before it overwrites in place and keeps its size.
+ * The array must outlive the writer.
+ */
+class GX_API GByteWriter
+{
+public:
+    explicit GByteWriter(GByteArray &buffer);
+
+    GByteWriter(GByteArray &buffer, int64_t pos);
+
+public:
+    GByteArray &buffer() const;
+
+    /**
+     * @brief Write data, byte order converted as the buffer specifies
+     * @param data
+     * @param size
+     */
+    void write(const void *data, int64_t size);
+
+    template<typename Type>
+    void write(const Type &in)
+    {
+        write(reinterpret_cast<const unsigned char *>(&in), sizeof(Type));
+    }
+
+    void write(const std::string &in);
+
+    void write(const GString &in);
+
+    void write(const GByteArray &in);
+
+    void write(const std::vector<uint8_t> &in);
+
+    void write(const GAny &any);
+
+    /**
+     * @brief Seek the write position within the written range of the buffer
+     *
+     * @param mode SEEK_SET/SEEK_CUR/SEEK_END
+     * @param size Positive and negative values represent direction, positive to right, negative to left
+     */
+    void seek(int mode, int64_t size);
+
+    int64_t pos() const;
+
+private:
+    GByteArray *mBuffer;
+    int64_t mPos;
+};
+
+
 template<typename T>
 using is_supported_gb_stream_t = std::enable_if_t<
     std::is_same_v<char, T> ||
@@ -404,6 +614,20 @@ GByteArray &operator>>(GByteArray &ba, Type &out)
     return ba;
 }
 
+template<typename Type, typename = is_supported_gb_stream_t<Type> >
+GByteReader &operator>>(GByteReader &reader, Type &out)
+{
+    reader.read(out);
+    return reader;
+}
+
+template<typename Type, typename = is_supported_gb_stream_t<Type> >
+GByteWriter &operator<<(GByteWriter &writer, const Type &in)
+{
+    writer.write(in);
+    return writer;
+}
+
 inline bool operator==(const GByteArray &lhs, const GByteArray &rhs)
 {
     return lhs.compare(rhs);
@@ -0,0 +1,165 @@
+//
+// Created by Gxin on 2024/4/3.
+//
+
+#ifndef GX_GEPOCH_H
+#define GX_GEPOCH_H
+
+#include "gx/gglobal.h"
+
+#include "gmutex.h"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+
+/**
+ * @class GEpochDomain
+ * @brief Epoch based memory reclamation, frees the nodes unlinked from a lock-free structure once no reader can hold them.
+ *
+ * Readers pin the domain around every access to the shared nodes, a writer unlinks a node and retires it.
+ * The global epoch only moves forward once every pinned thread has seen the current one,
+ * a node retired in epoch E is freed when the epoch reaches E + 2, at which point the threads pinned
+ * when it was unlinked have all left their critical sections.
+ * Each thread keeps its own retire list, reclaimed every RETIRE_THRESHOLD retirements or by flush().
+ * The list of an exiting thread goes to the domain and is reclaimed by the next flush().
+ *
+ * A thread pinned for long stalls the reclamation of every thread, pins must stay short
+ * and must not be held across blocking calls.
+ */
+class GX_API GEpochDomain
+{
+public:
+    using Deleter = void (*)(void *);
+
+    static constexpr size_t RETIRE_THRESHOLD = 64;
+
+    class Guard;
+
+public:
+    explicit GEpochDomain();
+
+    /**
+     * @brief Frees everything still retired, no thread may be pinned anymore
+     */
+    ~GEpochDomain();
+
+    GEpochDomain(const GEpochDomain &) = delete;
+
+    GEpochDomain &operator=(const GEpochDomain &) = delete;
+
+public:
+    /**
+     * @brief Shared domain of the process, never destroyed
+     */
+    static GEpochDomain &global();
+
+    /**
+     * @brief Enter a read critical section, pins nest
+     */
+    Guard pin();
+
+    void retire(void *p, Deleter deleter);
+
+    template<typename T>
+    void retire(T *p)
+    {
+        retire(p, [](void *q) {
+            delete static_cast<T *>(q);
+        });
+    }
+
+    /**
+     * @brief Advance the epoch as far as the pinned threads allow and free what can be freed,
+     * including the lists left by exited threads.
+     * @return Number of nodes still waiting
+     */
+    size_t flush();
+
+    /**
+     * @brief Block until the nodes retired so far by this thread and by the exited threads are freed,
+     * the calling thread must not be pinned
+     */
+    void synchronize();
+
+    uint64_t epoch() const noexcept
+    {
+        return mEpoch.load(std::memory_order_acquire);
+    }
+
+private:
+    struct Retired
+    {
+        void *p;
+        Deleter deleter;
+        uint64_t epoch;
+    };
+
+    struct alignas(GX_CACHE_LINE_SIZE) Record
+    {
+        std::atomic<uint64_t> state{0};     // epoch << 1 | 1 while pinned, 0 otherwise
+        std::atomic<bool> inUse{false};
+        uint32_t nesting = 0;
+        Record *next = nullptr;             // Immutable once published
+        std::vector<Retired> retired;
+    };
+
+    Record *localRecord();
+
+    Record *acquireRecord();
+
+    void releaseRecord(Record *record);
+
+    void unpin(Record *record) noexcept;
+
+    bool tryAdvance() noexcept;
+
+    size_t reclaim(std::vector<Retired> &retired);
+
+    friend struct GEpochThreadCache;
+
+private:
+    const uint64_t mId;
+    alignas(GX_CACHE_LINE_SIZE) std::atomic<uint64_t> mEpoch{1};
+    std::atomic<Record *> mRecords{nullptr};
+    GMutex mOrphanLock;
+    std::vector<Retired> mOrphans;
+};
+
+
+class GEpochDomain::Guard
+{
+public:
+    Guard(Guard &&rhs) noexcept
+            : mDomain(rhs.mDomain), mRecord(rhs.mRecord)
+    {
+        rhs.mRecord = nullptr;
+    }
+
+    Guard &operator=(Guard &&) = delete;
+
+    Guard(const Guard &) = delete;
+
+    Guard &operator=(const Guard &) = delete;
+
+    ~Guard() noexcept
+    {
+        if (mRecord) {
+            mDomain->unpin(mRecord);
+        }
+    }
+
+private:
+    friend class GEpochDomain;
+
+    Guard(GEpochDomain *domain, Record *record) noexcept
+            : mDomain(domain), mRecord(record)
+    {}
+
+private:
+    GEpochDomain *mDomain;
+    Record *mRecord;
+};
+
+#endif //GX_GEPOCH_H
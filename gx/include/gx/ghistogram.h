@@ -0,0 +1,201 @@
+//
+// Created by Gxin on 2024/3/16.
+//
+
+#ifndef GX_GHISTOGRAM_H
+#define GX_GHISTOGRAM_H
+
+#include "gx/gglobal.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <limits>
+#include <vector>
+
+
+/**
+ * @class GHistogram
+ * @brief Lock-free log-linear (HDR style) histogram of non-negative 64-bit values.
+ *
+ * Each power of two range is split into 2^SUB_BUCKET_BITS linear sub buckets,
+ * so the relative error of a recorded value is at most 1 / 2^SUB_BUCKET_BITS (6.25%).
+ * record() is wait-free: one relaxed fetch_add on the bucket plus count/sum,
+ * min/max only retry while they actually change.
+ * Snapshots are not an atomic cut across buckets, values recorded concurrently may or may not be included.
+ */
+class GHistogram
+{
+public:
+    static constexpr uint32_t SUB_BUCKET_BITS = 4;
+    static constexpr uint32_t SUB_BUCKET_COUNT = 1u << SUB_BUCKET_BITS;
+    static constexpr uint32_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+    /**
+     * @brief Point-in-time copy of a histogram, can be merged and queried for percentiles.
+     */
+    struct Snapshot
+    {
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        uint64_t min = 0;
+        uint64_t max = 0;
+        std::vector<uint64_t> buckets;
+
+        double mean() const
+        {
+            return count ? static_cast<double>(sum) / static_cast<double>(count) : 0.0;
+        }
+
+        /**
+         * @brief Returns the value below which p percent of the recorded values fall.
+         * @param p 0 ~ 100
+         * @return  The upper bound of the matched bucket, clamped to [min, max]
+         */
+        uint64_t percentile(double p) const
+        {
+            if (count == 0 || buckets.empty()) {
+                return 0;
+            }
+            p = std::clamp(p, 0.0, 100.0);
+            const auto target = std::max<uint64_t>(1, static_cast<uint64_t>(p / 100.0 * static_cast<double>(count) + 0.5));
+            uint64_t acc = 0;
+            for (uint32_t i = 0; i < buckets.size(); i++) {
+                acc += buckets[i];
+                if (acc >= target) {
+                    return std::clamp(bucketUpperBound(i), min, max);
+                }
+            }
+            return max;
+        }
+
+        void merge(const Snapshot &other)
+        {
+            if (other.count == 0) {
+                return;
+            }
+            if (buckets.size() < other.buckets.size()) {
+                buckets.resize(other.buckets.size(), 0);
+            }
+            for (size_t i = 0; i < other.buckets.size(); i++) {
+                buckets[i] += other.buckets[i];
+            }
+            min = count == 0 ? other.min : std::min(min, other.min);
+            max = count == 0 ? other.max : std::max(max, other.max);
+            count += other.count;
+            sum += other.sum;
+        }
+    };
+
+public:
+    explicit GHistogram() = default;
+
+    GHistogram(const GHistogram &) = delete;
+
+    GHistogram &operator=(const GHistogram &) = delete;
+
+public:
+    void record(uint64_t value) noexcept
+    {
+        mBuckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        mCount.fetch_add(1, std::memory_order_relaxed);
+        mSum.fetch_add(value, std::memory_order_relaxed);
+
+        uint64_t cur = mMin.load(std::memory_order_relaxed);
+        while (value < cur && !mMin.compare_exchange_weak(cur, value, std::memory_order_relaxed)) {
+        }
+        cur = mMax.load(std::memory_order_relaxed);
+        while (value > cur && !mMax.compare_exchange_weak(cur, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    /**
+     * @brief Copy the current state.
+     * @return
+     */
+    Snapshot snapshot() const
+    {
+        Snapshot s;
+        s.buckets.resize(BUCKET_COUNT);
+        for (uint32_t i = 0; i < BUCKET_COUNT; i++) {
+            s.buckets[i] = mBuckets[i].load(std::memory_order_relaxed);
+        }
+        s.count = mCount.load(std::memory_order_relaxed);
+        s.sum = mSum.load(std::memory_order_relaxed);
+        s.min = s.count ? mMin.load(std::memory_order_relaxed) : 0;
+        s.max = mMax.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    /**
+     * @brief Copy the current state and clear each counter while reading it,
+     * values recorded concurrently go either to the returned snapshot or to the next one.
+     * @return
+     */
+    Snapshot snapshotAndReset()
+    {
+        Snapshot s;
+        s.buckets.resize(BUCKET_COUNT);
+        for (uint32_t i = 0; i < BUCKET_COUNT; i++) {
+            s.buckets[i] = mBuckets[i].exchange(0, std::memory_order_relaxed);
+        }
+        s.count = mCount.exchange(0, std::memory_order_relaxed);
+        s.sum = mSum.exchange(0, std::memory_order_relaxed);
+        s.min = mMin.exchange(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+        s.max = mMax.exchange(0, std::memory_order_relaxed);
+        if (s.count == 0) {
+            s.min = 0;
+        }
+        return s;
+    }
+
+    void reset() noexcept
+    {
+        for (auto &bucket: mBuckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        mCount.store(0, std::memory_order_relaxed);
+        mSum.store(0, std::memory_order_relaxed);
+        mMin.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+        mMax.store(0, std::memory_order_relaxed);
+    }
+
+public:
+    static uint32_t bucketIndex(uint64_t value) noexcept
+    {
+        if (value < SUB_BUCKET_COUNT) {
+            return static_cast<uint32_t>(value);
+        }
+        const uint32_t msb = 63 - std::countl_zero(value);
+        const uint32_t group = msb - SUB_BUCKET_BITS + 1;
+        const uint32_t sub = static_cast<uint32_t>(value >> (msb - SUB_BUCKET_BITS)) & (SUB_BUCKET_COUNT - 1);
+        return group * SUB_BUCKET_COUNT + sub;
+    }
+
+    static uint64_t bucketLowerBound(uint32_t index) noexcept
+    {
+        const uint32_t group = index / SUB_BUCKET_COUNT;
+        const uint64_t sub = index % SUB_BUCKET_COUNT;
+        if (group == 0) {
+            return sub;
+        }
+        return (SUB_BUCKET_COUNT + sub) << (group - 1);
+    }
+
+    static uint64_t bucketUpperBound(uint32_t index) noexcept
+    {
+        if (index + 1 >= BUCKET_COUNT) {
+            return std::numeric_limits<uint64_t>::max();
+        }
+        return bucketLowerBound(index + 1) - 1;
+    }
+
+private:
+    std::atomic<uint64_t> mBuckets[BUCKET_COUNT]{};
+    std::atomic<uint64_t> mCount{0};
+    std::atomic<uint64_t> mSum{0};
+    std::atomic<uint64_t> mMin{std::numeric_limits<uint64_t>::max()};
+    std::atomic<uint64_t> mMax{0};
+};
+
+#endif //GX_GHISTOGRAM_H
@@ -7,84 +7,404 @@
 
 #include "gmutex.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <limits>
-#include <deque>
+#include <type_traits>
+#include <vector>
 
 
 /**
  * ID allocator
  * ID fast allocation algorithm
+ *
+ * IDs start at 1, 0 is never handed out. The state of the IDs lives in segments that double in size
+ * and are only allocated once an ID of their range is used, memory follows the highest ID in use.
+ * alloc() and free() are lock-free: freed IDs go to a tagged Treiber stack and fresh IDs come from
+ * an atomic counter, a LocalCache per thread keeps a batch of free IDs off the shared stack.
+ * Each ID carries a generation bumped by free(), isValid(id, generation) tells a recycled ID apart.
+ * IDs are limited to 32 bits whatever ID_TYPE is.
+ *
+ * @tparam ID_TYPE
+ * @tparam MaxNum   IDs are below MaxNum
+ * @tparam MUTEX    Kept for compatibility, the allocator no longer locks
  */
 template<typename ID_TYPE, ID_TYPE MaxNum = std::numeric_limits<ID_TYPE>::max(), typename MUTEX = GNoLock>
 class GIDAllocator final
 {
 public:
-    explicit GIDAllocator()
-        : mGens(new uint8_t[MaxNum])
-    {
-        reset();
-    }
+    class LocalCache;
+
+public:
+    explicit GIDAllocator() = default;
 
     ~GIDAllocator()
     {
-        delete[] mGens;
+        for (auto &segment: mSegments) {
+            delete[] segment.load(std::memory_order_relaxed);
+        }
     }
 
+    GIDAllocator(const GIDAllocator &) = delete;
+
+    GIDAllocator &operator=(const GIDAllocator &) = delete;
+
 public:
+    /**
+     * @brief Free every ID, must not run concurrently with the other calls.
+     * The segments are kept and the generations keep counting, the handles from before stay stale.
+     */
     void reset()
     {
-        std::lock_guard locker(mMutex);
-
-        mCurrentId = 1;
-        std::fill_n(mGens, MaxNum, 0);
-        mFreeList.clear();
+        const uint64_t highWater = std::min<uint64_t>(mNextId.load(std::memory_order_relaxed), ID_LIMIT);
+        for (uint64_t id = 1; id < highWater; id++) {
+            Entry &e = entry(static_cast<uint32_t>(id));
+            const uint32_t state = e.state.load(std::memory_order_relaxed);
+            if (state & LIVE) {
+                e.state.store(state + 1, std::memory_order_relaxed);
+            }
+        }
+        mFreeHead.store(0, std::memory_order_relaxed);
+        mNextId.store(1, std::memory_order_relaxed);
     }
 
+    /**
+     * @return 0 when the IDs are exhausted
+     */
     ID_TYPE alloc()
     {
-        std::lock_guard locker(mMutex);
-
-        if (!mFreeList.empty()) {
-            ID_TYPE id = mFreeList.front();
-            mFreeList.pop_front();
-            mGens[id] = 1;
-            return id;
-        }
-        if (mCurrentId >= MaxNum) {
+        uint32_t id;
+        if (takeIds(&id, 1) == 0) {
             return 0;
         }
-        ID_TYPE id = mCurrentId++;
-        mGens[id] = 1;
-        return id;
+        markLive(id);
+        return static_cast<ID_TYPE>(id);
+    }
+
+    /**
+     * @brief Allocate up to count IDs
+     * @return How many were allocated, less than count only when the IDs are exhausted
+     */
+    size_t allocBulk(ID_TYPE *ids, size_t count)
+    {
+        if constexpr (std::is_same_v<ID_TYPE, uint32_t>) {
+            const size_t n = takeIds(ids, count);
+            for (size_t i = 0; i < n; i++) {
+                markLive(ids[i]);
+            }
+            return n;
+        } else {
+            // Other widths go through a stack batch, writing uint32_t IDs into the caller's buffer would alias it
+            uint32_t batch[BULK_BATCH];
+            size_t n = 0;
+            while (n < count) {
+                const size_t want = std::min(count - n, BULK_BATCH);
+                const size_t taken = takeIds(batch, want);
+                for (size_t i = 0; i < taken; i++) {
+                    markLive(batch[i]);
+                    ids[n + i] = static_cast<ID_TYPE>(batch[i]);
+                }
+                n += taken;
+                if (taken < want) {
+                    break;
+                }
+            }
+            return n;
+        }
     }
 
     void free(ID_TYPE id)
     {
-        if (!isValid(id)) {
+        if (!markDead(id)) {
             return;
         }
+        const auto freed = static_cast<uint32_t>(id);
+        putIds(&freed, 1);
+    }
 
-        std::lock_guard locker(mMutex);
+    /**
+     * @brief Free the IDs with one push to the shared free stack per BULK_BATCH IDs, invalid IDs are skipped
+     */
+    void freeBulk(const ID_TYPE *ids, size_t count)
+    {
+        uint32_t batch[BULK_BATCH];
+        size_t n = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (!markDead(ids[i])) {
+                continue;
+            }
+            batch[n++] = static_cast<uint32_t>(ids[i]);
+            if (n == BULK_BATCH) {
+                putIds(batch, n);
+                n = 0;
+            }
+        }
+        putIds(batch, n);
+    }
 
-        mFreeList.push_back(id);
-        mGens[id] = 0;
+    bool isValid(ID_TYPE id) const
+    {
+        const Entry *e = find(id);
+        return e && (e->state.load(std::memory_order_acquire) & LIVE);
+    }
+
+    /**
+     * @brief Whether the ID is allocated and still has the generation it was handed out with
+     */
+    bool isValid(ID_TYPE id, uint32_t generation) const
+    {
+        const Entry *e = find(id);
+        return e && e->state.load(std::memory_order_acquire) == ((generation << 1) | LIVE);
+    }
+
+    /**
+     * @brief Current generation of the ID, bumped each time it is freed
+     */
+    uint32_t generation(ID_TYPE id) const
+    {
+        const Entry *e = find(id);
+        return e ? e->state.load(std::memory_order_acquire) >> 1 : 0;
     }
 
-    bool isValid(ID_TYPE id)
+    /**
+     * @brief Highest ID handed out so far plus one
+     */
+    uint64_t highWater() const
     {
-        if (id <= 0 || id >= MaxNum) {
+        return std::min<uint64_t>(mNextId.load(std::memory_order_relaxed), ID_LIMIT);
+    }
+
+    /**
+     * @brief Bytes held by the allocated segments
+     */
+    size_t memoryUsage() const
+    {
+        size_t bytes = 0;
+        for (size_t s = 0; s < SEGMENT_COUNT; s++) {
+            if (mSegments[s].load(std::memory_order_relaxed)) {
+                bytes += segmentSize(s) * sizeof(Entry);
+            }
+        }
+        return bytes;
+    }
+
+private:
+    static constexpr uint64_t ID_LIMIT = std::min<uint64_t>(static_cast<uint64_t>(MaxNum),
+                                                            std::numeric_limits<uint32_t>::max());
+    static constexpr uint32_t LIVE = 1;
+    static constexpr size_t BULK_BATCH = 64;     // IDs per stack batch of allocBulk()/freeBulk()
+    static constexpr uint32_t SEGMENT_BASE_BITS = 10;
+    static constexpr uint64_t SEGMENT_BASE = uint64_t(1) << SEGMENT_BASE_BITS;
+    static constexpr size_t SEGMENT_COUNT = std::bit_width(ID_LIMIT / SEGMENT_BASE + 1);
+
+    struct Entry
+    {
+        std::atomic<uint32_t> state{0};     // generation << 1 | LIVE
+        std::atomic<uint32_t> next{0};      // Next ID of the free stack
+    };
+
+    // Segment s holds SEGMENT_BASE << s IDs starting at SEGMENT_BASE * (2^s - 1), the last one stops at ID_LIMIT
+    static size_t segmentOf(uint32_t id) noexcept
+    {
+        return std::bit_width(id / SEGMENT_BASE + 1) - 1;
+    }
+
+    static uint64_t segmentBegin(size_t s) noexcept
+    {
+        return SEGMENT_BASE * ((uint64_t(1) << s) - 1);
+    }
+
+    static uint64_t segmentSize(size_t s) noexcept
+    {
+        const uint64_t begin = segmentBegin(s);
+        return begin < ID_LIMIT ? std::min(SEGMENT_BASE << s, ID_LIMIT - begin) : 0;
+    }
+
+    Entry &entry(uint32_t id) const noexcept
+    {
+        const size_t s = segmentOf(id);
+        return mSegments[s].load(std::memory_order_acquire)[id - segmentBegin(s)];
+    }
+
+    const Entry *find(ID_TYPE id) const noexcept
+    {
+        if (id <= 0 || static_cast<uint64_t>(id) >= ID_LIMIT) {
+            return nullptr;
+        }
+        const auto id32 = static_cast<uint32_t>(id);
+        const size_t s = segmentOf(id32);
+        const Entry *segment = mSegments[s].load(std::memory_order_acquire);
+        return segment ? &segment[id32 - segmentBegin(s)] : nullptr;
+    }
+
+    void ensureSegments(uint64_t begin, uint64_t end)
+    {
+        for (size_t s = segmentOf(static_cast<uint32_t>(begin)); s <= segmentOf(static_cast<uint32_t>(end - 1)); s++) {
+            if (mSegments[s].load(std::memory_order_acquire)) {
+                continue;
+            }
+            Entry *segment = new Entry[segmentSize(s)];
+            Entry *expected = nullptr;
+            if (!mSegments[s].compare_exchange_strong(expected, segment, std::memory_order_acq_rel)) {
+                delete[] segment;
+            }
+        }
+    }
+
+    void markLive(uint32_t id) noexcept
+    {
+        entry(id).state.fetch_or(LIVE, std::memory_order_release);
+    }
+
+    /**
+     * @brief Clear the live bit and bump the generation, false if the ID was not live (double free)
+     */
+    bool markDead(ID_TYPE id) noexcept
+    {
+        const Entry *found = find(id);
+        if (!found) {
             return false;
         }
-        return mGens[id] == 1;
+        auto &state = const_cast<Entry *>(found)->state;
+        uint32_t current = state.load(std::memory_order_relaxed);
+        do {
+            if (!(current & LIVE)) {
+                return false;
+            }
+        } while (!state.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel));
+        return true;
+    }
+
+    /**
+     * @brief Take count free IDs, recycled ones first then fresh ones, without marking them live
+     */
+    size_t takeIds(uint32_t *ids, size_t count)
+    {
+        size_t n = 0;
+        while (n < count) {
+            const uint32_t id = popFree();
+            if (!id) {
+                break;
+            }
+            ids[n++] = id;
+        }
+        if (n == count) {
+            return n;
+        }
+        const uint64_t begin = mNextId.fetch_add(count - n, std::memory_order_relaxed);
+        const uint64_t end = std::min<uint64_t>(begin + (count - n), ID_LIMIT);
+        if (begin >= end) {
+            return n;
+        }
+        ensureSegments(begin, end);
+        for (uint64_t id = begin; id < end; id++) {
+            ids[n++] = static_cast<uint32_t>(id);
+        }
+        return n;
+    }
+
+    uint32_t popFree() noexcept
+    {
+        uint64_t head = mFreeHead.load(std::memory_order_acquire);
+        while (true) {
+            const auto id = static_cast<uint32_t>(head);
+            if (!id) {
+                return 0;
+            }
+            // Entries are never released, a stale read of next only fails the tagged CAS
+            const uint32_t next = entry(id).next.load(std::memory_order_relaxed);
+            const uint64_t newHead = ((head >> 32) + 1) << 32 | next;
+            if (mFreeHead.compare_exchange_weak(head, newHead, std::memory_order_acq_rel)) {
+                return id;
+            }
+        }
+    }
+
+    /**
+     * @brief Push the IDs on the free stack as one chain
+     */
+    void putIds(const uint32_t *ids, size_t count) noexcept
+    {
+        if (count == 0) {
+            return;
+        }
+        for (size_t i = 0; i + 1 < count; i++) {
+            entry(ids[i]).next.store(ids[i + 1], std::memory_order_relaxed);
+        }
+        Entry &last = entry(ids[count - 1]);
+        uint64_t head = mFreeHead.load(std::memory_order_relaxed);
+        uint64_t newHead;
+        do {
+            last.next.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+            newHead = ((head >> 32) + 1) << 32 | ids[0];
+        } while (!mFreeHead.compare_exchange_weak(head, newHead, std::memory_order_acq_rel));
     }
 
 private:
-    ID_TYPE mCurrentId = 1;
-    uint8_t *const mGens;
+    mutable std::array<std::atomic<Entry *>, SEGMENT_COUNT> mSegments{};
+    alignas(GX_CACHE_LINE_SIZE) std::atomic<uint64_t> mFreeHead{0};   // Tag << 32 | ID
+    alignas(GX_CACHE_LINE_SIZE) std::atomic<uint64_t> mNextId{1};
+};
 
-    std::deque<ID_TYPE> mFreeList;
+/**
+ * @class GIDAllocator::LocalCache
+ * @brief Batch of free IDs owned by one thread, most alloc()/free() calls then touch no shared state.
+ * The cached IDs go back to the allocator when the cache is destroyed.
+ */
+template<typename ID_TYPE, ID_TYPE MaxNum, typename MUTEX>
+class GIDAllocator<ID_TYPE, MaxNum, MUTEX>::LocalCache
+{
+public:
+    explicit LocalCache(GIDAllocator &allocator, size_t capacity = 64)
+            : mAllocator(allocator),
+              mIds(std::max<size_t>(capacity, 2)),
+              mCount(0)
+    {}
 
-    MUTEX mMutex;
+    ~LocalCache()
+    {
+        mAllocator.putIds(mIds.data(), mCount);
+    }
+
+    LocalCache(const LocalCache &) = delete;
+
+    LocalCache &operator=(const LocalCache &) = delete;
+
+public:
+    ID_TYPE alloc()
+    {
+        if (mCount == 0) {
+            mCount = mAllocator.takeIds(mIds.data(), mIds.size() / 2);
+            if (mCount == 0) {
+                return 0;
+            }
+        }
+        const uint32_t id = mIds[--mCount];
+        mAllocator.markLive(id);
+        return static_cast<ID_TYPE>(id);
+    }
+
+    void free(ID_TYPE id)
+    {
+        if (!mAllocator.markDead(id)) {
+            return;
+        }
+        if (mCount == mIds.size()) {
+            // Hand the older half back in one push
+            const size_t half = mCount / 2;
+            mAllocator.putIds(mIds.data(), half);
+            std::copy(mIds.begin() + static_cast<ptrdiff_t>(half), mIds.begin() + static_cast<ptrdiff_t>(mCount), mIds.begin());
+            mCount -= half;
+        }
+        mIds[mCount++] = static_cast<uint32_t>(id);
+    }
+
+private:
+    GIDAllocator &mAllocator;
+    std::vector<uint32_t> mIds;
+    size_t mCount;
 };
 
 #endif //GX_GIDALLOCATOR_H
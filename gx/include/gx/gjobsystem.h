@@ -251,7 +251,7 @@ private:
 
 private:
     GMutex mWaitLock;
-    std::condition_variable mWaitCondition;
+    GConditionVariable mWaitCondition;
 
     std::atomic<int32_t> mActiveJobs = {0};
     GArena<ObjectPoolAllocator<Job>, GLockingPolicy::Mutex> mJobPool;
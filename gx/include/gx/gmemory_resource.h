@@ -0,0 +1,155 @@
+//
+// Created by Gxin on 2024/3/31.
+//
+
+#ifndef GX_GMEMORY_RESOURCE_H
+#define GX_GMEMORY_RESOURCE_H
+
+#include "allocator.h"
+
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+
+/**
+ * @class GArenaMemoryResource
+ * @brief std::pmr::memory_resource over a GArena, so that std::pmr containers of any element type
+ * share one arena without carrying the arena type like GSTLAllocator does.
+ * The arena must outlive the resource and the containers using it.
+ *
+ * @tparam ARENA
+ */
+template<typename ARENA>
+class GArenaMemoryResource : public std::pmr::memory_resource
+{
+public:
+    explicit GArenaMemoryResource(ARENA &arena) noexcept
+            : mArena(arena)
+    {}
+
+    ARENA &arena() noexcept
+    { return mArena; }
+
+protected:
+    void *do_allocate(size_t bytes, size_t alignment) override
+    {
+        void *p = mArena.alloc(bytes, alignment);
+        if (!p) {
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t) override
+    {
+        mArena.free(p, bytes);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+
+private:
+    ARENA &mArena;
+};
+
+
+/**
+ * @class GFrameMemoryResource
+ * @brief Monotonic resource over a GLinearAllocator, for per-frame or per-request containers.
+ * deallocate() is a no-op, everything is released at once by reset().
+ * Requests that do not fit the buffer go to the upstream resource and are given back at reset(),
+ * overflowCount() tells when the buffer should be made larger.
+ * Not thread safe.
+ */
+class GFrameMemoryResource : public std::pmr::memory_resource
+{
+public:
+    explicit GFrameMemoryResource(size_t capacity,
+                                  std::pmr::memory_resource *upstream = std::pmr::get_default_resource())
+            : mArea(capacity),
+              mAllocator(mArea),
+              mUpstream(upstream)
+    {}
+
+    ~GFrameMemoryResource() override
+    {
+        releaseOverflow();
+    }
+
+    GFrameMemoryResource(const GFrameMemoryResource &) = delete;
+
+    GFrameMemoryResource &operator=(const GFrameMemoryResource &) = delete;
+
+public:
+    void reset() noexcept
+    {
+        mAllocator.reset();
+        releaseOverflow();
+    }
+
+    size_t size() const noexcept
+    { return mAllocator.size(); }
+
+    size_t capacity() const noexcept
+    { return mAllocator.capacity(); }
+
+    size_t overflowCount() const noexcept
+    { return mOverflowCount; }
+
+    std::pmr::memory_resource *upstream() const noexcept
+    { return mUpstream; }
+
+protected:
+    void *do_allocate(size_t bytes, size_t alignment) override
+    {
+        if (void *p = mAllocator.alloc(bytes, alignment)) {
+            return p;
+        }
+        // The record goes first, a push_back throwing after the upstream allocation would leak the block
+        mOverflow.push_back({nullptr, bytes, alignment});
+        try {
+            mOverflow.back().p = mUpstream->allocate(bytes, alignment);
+        } catch (...) {
+            mOverflow.pop_back();
+            throw;
+        }
+        ++mOverflowCount;
+        return mOverflow.back().p;
+    }
+
+    void do_deallocate(void *, size_t, size_t) override
+    {}
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+
+private:
+    struct Overflow
+    {
+        void *p;
+        size_t bytes;
+        size_t alignment;
+    };
+
+    void releaseOverflow() noexcept
+    {
+        for (const auto &o: mOverflow) {
+            mUpstream->deallocate(o.p, o.bytes, o.alignment);
+        }
+        mOverflow.clear();
+    }
+
+private:
+    GHeapArea mArea;
+    GLinearAllocator mAllocator;
+    std::pmr::memory_resource *mUpstream;
+    std::vector<Overflow> mOverflow;
+    size_t mOverflowCount = 0;
+};
+
+#endif //GX_GMEMORY_RESOURCE_H
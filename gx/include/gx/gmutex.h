@@ -8,14 +8,41 @@
 #include "graii.h"
 
 #include <atomic>
+#include <cstdint>
 #include <cassert>
 #include <chrono>
+#include <condition_variable>
 #include <mutex>
 #include <thread>
 #include <shared_mutex>
+#include <source_location>
+#include <string>
+#include <vector>
 
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+
+namespace gx
+{
+/**
+ * @brief Hint to the CPU that this is a spin-wait loop
+ */
+inline void cpuRelax() noexcept
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_pause();
+#elif defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield");
+#else
+    std::this_thread::yield();
+#endif
+}
+} // gx
 
-using GMutex = std::mutex;
 
 using GRecursiveMutex = std::recursive_mutex;
 
@@ -42,27 +69,36 @@ public:
 };
 
 
-class GSpinLock
+class GRawSpinLock
 {
 public:
-    explicit GSpinLock() = default;
+    explicit GRawSpinLock() = default;
 
-    ~GSpinLock() = default;
+    ~GRawSpinLock() = default;
 
-    GSpinLock(const GSpinLock &b) = delete;
+    GRawSpinLock(const GRawSpinLock &b) = delete;
 
-    GSpinLock &operator=(const GSpinLock &b) = delete;
+    GRawSpinLock &operator=(const GRawSpinLock &b) = delete;
 
 public:
     void lock() noexcept
     {
-        while (mFlag.test_and_set()) {
+        while (mFlag.test_and_set(std::memory_order_acquire)) {
+            // Wait on a shared copy of the line, only retry the write once it looks free
+            while (mFlag.test(std::memory_order_relaxed)) {
+                gx::cpuRelax();
+            }
         }
     }
 
+    bool try_lock() noexcept
+    {
+        return !mFlag.test(std::memory_order_relaxed) && !mFlag.test_and_set(std::memory_order_acquire);
+    }
+
     void unlock() noexcept
     {
-        mFlag.clear();
+        mFlag.clear(std::memory_order_release);
     }
 
 private:
@@ -70,16 +106,73 @@ private:
 };
 
 
-class GRWLock
+/**
+ * @class GRawAdaptiveLock
+ * @brief Mutex that spins briefly and then parks, for short critical sections under contention.
+ *
+ * The uncontended lock()/unlock() is a single atomic operation. A contended lock() spins with
+ * test-and-test-and-set and an exponential pause backoff, which covers a holder about to unlock,
+ * then sleeps on a futex (WaitOnAddress / std::atomic::wait elsewhere) so a preempted holder
+ * does not cost the waiters their time slice. Single core machines skip the spinning.
+ */
+class GX_API GRawAdaptiveLock
 {
 public:
-    explicit GRWLock() = default;
+    explicit GRawAdaptiveLock() = default;
 
-    ~GRWLock() = default;
+    ~GRawAdaptiveLock() = default;
 
-    GRWLock(const GRWLock &b) = delete;
+    GRawAdaptiveLock(const GRawAdaptiveLock &b) = delete;
 
-    GRWLock &operator=(const GRWLock &b) = delete;
+    GRawAdaptiveLock &operator=(const GRawAdaptiveLock &b) = delete;
+
+public:
+    void lock() noexcept
+    {
+        uint32_t expected = UNLOCKED;
+        if (!mState.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed)) {
+            lockSlow();
+        }
+    }
+
+    bool try_lock() noexcept
+    {
+        uint32_t expected = UNLOCKED;
+        return mState.load(std::memory_order_relaxed) == UNLOCKED
+               && mState.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void unlock() noexcept
+    {
+        if (mState.exchange(UNLOCKED, std::memory_order_release) == CONTENDED) {
+            wake();
+        }
+    }
+
+private:
+    static constexpr uint32_t UNLOCKED = 0;
+    static constexpr uint32_t LOCKED = 1;
+    static constexpr uint32_t CONTENDED = 2;    // Locked, a thread may be parked
+
+    void lockSlow() noexcept;
+
+    void wake() noexcept;
+
+private:
+    std::atomic<uint32_t> mState{UNLOCKED};
+};
+
+
+class GRawRWLock
+{
+public:
+    explicit GRawRWLock() = default;
+
+    ~GRawRWLock() = default;
+
+    GRawRWLock(const GRawRWLock &b) = delete;
+
+    GRawRWLock &operator=(const GRawRWLock &b) = delete;
 
 public:
     void readLock()
@@ -87,6 +180,11 @@ public:
         mMutex.lock_shared();
     }
 
+    bool tryReadLock()
+    {
+        return mMutex.try_lock_shared();
+    }
+
     void readUnlock()
     {
         mMutex.unlock_shared();
@@ -97,6 +195,11 @@ public:
         mMutex.lock();
     }
 
+    bool tryWriteLock()
+    {
+        return mMutex.try_lock();
+    }
+
     void writeUnlock()
     {
         mMutex.unlock();
@@ -104,12 +207,12 @@ public:
 
     GRaii readGuard() noexcept
     {
-        return gx::makeRAII(*this, &GRWLock::readUnlock, &GRWLock::readLock);
+        return gx::makeRAII(*this, &GRawRWLock::readUnlock, &GRawRWLock::readLock);
     }
 
     GRaii writeGuard() noexcept
     {
-        return gx::makeRAII(*this, &GRWLock::writeUnlock, &GRWLock::writeLock);
+        return gx::makeRAII(*this, &GRawRWLock::writeUnlock, &GRawRWLock::writeLock);
     }
 
 private:
@@ -198,6 +301,459 @@ private:
 };
 
 
+/**
+ * @class GRawReaderBiasedRWLock
+ * @brief Big-reader lock for read-mostly data, readers scale with the core count and writers are expensive.
+ *
+ * A reader only touches the counter of its own slot, each slot sits on its own cache line and the
+ * thread picks it from a hash of its id, so readers on different cores do not share a written line.
+ * A writer raises the writer flag, then waits for the counters of every slot to drain.
+ * Readers arriving meanwhile back off until the writer is done, so writers are not starved.
+ * No lock is recursive: a thread holding a read lock must not take it again, with a writer pending the nested
+ * readLock() waits for the writer while the writer waits for the outer read lock. Nor may a thread upgrade a read lock.
+ */
+class GRawReaderBiasedRWLock
+{
+public:
+    static constexpr uint32_t READER_SLOTS = 64;
+
+    explicit GRawReaderBiasedRWLock() = default;
+
+    ~GRawReaderBiasedRWLock() = default;
+
+    GRawReaderBiasedRWLock(const GRawReaderBiasedRWLock &b) = delete;
+
+    GRawReaderBiasedRWLock &operator=(const GRawReaderBiasedRWLock &b) = delete;
+
+public:
+    void readLock() noexcept
+    {
+        std::atomic<uint32_t> &readers = mSlots[slotIndex()].readers;
+        while (true) {
+            // Pairs with the flag store and slot loads of writeLock(), one of the two sees the other
+            readers.fetch_add(1, std::memory_order_seq_cst);
+            if (mWriter.load(std::memory_order_seq_cst) == 0) {
+                return;
+            }
+            readers.fetch_sub(1, std::memory_order_release);
+            waitWriter();
+        }
+    }
+
+    bool tryReadLock() noexcept
+    {
+        std::atomic<uint32_t> &readers = mSlots[slotIndex()].readers;
+        readers.fetch_add(1, std::memory_order_seq_cst);
+        if (mWriter.load(std::memory_order_seq_cst) == 0) {
+            return true;
+        }
+        readers.fetch_sub(1, std::memory_order_release);
+        return false;
+    }
+
+    void readUnlock() noexcept
+    {
+        mSlots[slotIndex()].readers.fetch_sub(1, std::memory_order_release);
+    }
+
+    void writeLock() noexcept
+    {
+        mWriterLock.lock();
+        mWriter.store(1, std::memory_order_seq_cst);
+        for (const auto &slot: mSlots) {
+            for (int32_t spin = 0; slot.readers.load(std::memory_order_seq_cst) != 0; spin++) {
+                if (spin < 64) {
+                    gx::cpuRelax();
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+
+    bool tryWriteLock() noexcept
+    {
+        if (!mWriterLock.try_lock()) {
+            return false;
+        }
+        mWriter.store(1, std::memory_order_seq_cst);
+        for (const auto &slot: mSlots) {
+            if (slot.readers.load(std::memory_order_seq_cst) != 0) {
+                writeUnlock();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void writeUnlock() noexcept
+    {
+        mWriter.store(0, std::memory_order_release);
+        mWriter.notify_all();
+        mWriterLock.unlock();
+    }
+
+    GRaii readGuard() noexcept
+    {
+        return gx::makeRAII(*this, &GRawReaderBiasedRWLock::readUnlock, &GRawReaderBiasedRWLock::readLock);
+    }
+
+    GRaii writeGuard() noexcept
+    {
+        return gx::makeRAII(*this, &GRawReaderBiasedRWLock::writeUnlock, &GRawReaderBiasedRWLock::writeLock);
+    }
+
+private:
+    struct alignas(GX_CACHE_LINE_SIZE) Slot
+    {
+        std::atomic<uint32_t> readers{0};
+    };
+
+    /**
+     * @brief Derived from the thread id rather than a thread_local, lock and unlock must find the same slot
+     * even when they are inlined in different modules
+     */
+    static uint32_t slotIndex() noexcept
+    {
+        static_assert((READER_SLOTS & (READER_SLOTS - 1)) == 0, "READER_SLOTS must be a power of two");
+        const uint64_t h = std::hash<std::thread::id>()(std::this_thread::get_id());
+        return static_cast<uint32_t>((h * 0x9E3779B97F4A7C15ull) >> 32) & (READER_SLOTS - 1);
+    }
+
+    void waitWriter() noexcept
+    {
+        for (int32_t spin = 0; spin < 64; spin++) {
+            if (mWriter.load(std::memory_order_acquire) == 0) {
+                return;
+            }
+            gx::cpuRelax();
+        }
+        mWriter.wait(1, std::memory_order_acquire);
+    }
+
+private:
+    Slot mSlots[READER_SLOTS];
+    alignas(GX_CACHE_LINE_SIZE) std::atomic<uint32_t> mWriter{0};
+    GRawAdaptiveLock mWriterLock;
+};
+
+
+// ------------------------------------------------------------------------------------------------
+// Profiling
+// ------------------------------------------------------------------------------------------------
+
+/**
+ * @brief Contention statistics of the locks sharing a name
+ */
+struct GLockStats
+{
+    std::string name;
+    uint64_t lockCount = 0;         // Instances merged in this entry, including destroyed ones
+    uint64_t acquisitions = 0;
+    uint64_t contendedAcquisitions = 0;
+    uint64_t totalWaitNs = 0;
+    uint64_t maxWaitNs = 0;
+    uint64_t totalHoldNs = 0;
+    uint64_t maxHoldNs = 0;
+};
+
+
+/**
+ * @class GLockTracker
+ * @brief Counters of one profiled lock, registered in GLockRegistry for its lifetime.
+ * A lock without a name is named after the place it was constructed.
+ */
+class GX_API GLockTracker
+{
+public:
+    explicit GLockTracker(const char *name, const std::source_location &location) noexcept;
+
+    ~GLockTracker() noexcept;
+
+    GLockTracker(const GLockTracker &) = delete;
+
+    GLockTracker &operator=(const GLockTracker &) = delete;
+
+public:
+    static int64_t now() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void onAcquire() noexcept
+    {
+        mAcquisitions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void onContendedAcquire(int64_t waitNs) noexcept
+    {
+        mAcquisitions.fetch_add(1, std::memory_order_relaxed);
+        mContendedAcquisitions.fetch_add(1, std::memory_order_relaxed);
+        mTotalWaitNs.fetch_add(waitNs, std::memory_order_relaxed);
+        updateMax(mMaxWaitNs, waitNs);
+    }
+
+    void onRelease(int64_t holdNs) noexcept
+    {
+        mTotalHoldNs.fetch_add(holdNs, std::memory_order_relaxed);
+        updateMax(mMaxHoldNs, holdNs);
+    }
+
+    GLockStats stats() const;
+
+    void resetCounters() noexcept;
+
+private:
+    friend class GLockRegistry;
+
+    static void updateMax(std::atomic<uint64_t> &max, int64_t value) noexcept
+    {
+        const auto v = static_cast<uint64_t>(value);
+        uint64_t current = max.load(std::memory_order_relaxed);
+        while (v > current && !max.compare_exchange_weak(current, v, std::memory_order_relaxed)) {
+        }
+    }
+
+private:
+    std::string mName;
+    std::atomic<uint64_t> mAcquisitions{0};
+    std::atomic<uint64_t> mContendedAcquisitions{0};
+    std::atomic<uint64_t> mTotalWaitNs{0};
+    std::atomic<uint64_t> mMaxWaitNs{0};
+    std::atomic<uint64_t> mTotalHoldNs{0};
+    std::atomic<uint64_t> mMaxHoldNs{0};
+    size_t mRegistryIndex = 0;      // Position in the registry, guarded by its lock
+};
+
+
+/**
+ * @class GLockRegistry
+ * @brief Process wide view of the profiled locks, the statistics of destroyed locks are kept under their name.
+ * Empty unless locks are profiled, see GX_LOCK_PROFILING.
+ */
+class GX_API GLockRegistry
+{
+public:
+    /**
+     * @return The statistics merged by lock name, the longest total wait first
+     */
+    static std::vector<GLockStats> snapshot();
+
+    static void dump();
+
+    /**
+     * @brief Start a new measurement window, forgets the destroyed locks and zeroes the live ones
+     */
+    static void reset();
+
+private:
+    friend class GLockTracker;
+
+    static void add(GLockTracker *tracker);
+
+    static void remove(GLockTracker *tracker);
+};
+
+
+/**
+ * @class GProfiledLock
+ * @brief Exclusive lock recording its acquisitions, contended acquisitions, wait and hold times.
+ * An acquisition is contended when try_lock() fails first.
+ *
+ * @tparam LOCK Lock with lock(), try_lock() and unlock()
+ */
+template<typename LOCK>
+class GProfiledLock
+{
+public:
+    explicit GProfiledLock(const char *name = nullptr,
+                           const std::source_location &location = std::source_location::current()) noexcept
+        : mTracker(name, location)
+    {
+    }
+
+    ~GProfiledLock() = default;
+
+    GProfiledLock(const GProfiledLock &b) = delete;
+
+    GProfiledLock &operator=(const GProfiledLock &b) = delete;
+
+public:
+    void lock()
+    {
+        if (mLock.try_lock()) {
+            mTracker.onAcquire();
+            mAcquiredAt = GLockTracker::now();
+            return;
+        }
+        const int64_t t0 = GLockTracker::now();
+        mLock.lock();
+        mAcquiredAt = GLockTracker::now();
+        mTracker.onContendedAcquire(mAcquiredAt - t0);
+    }
+
+    bool try_lock()
+    {
+        if (!mLock.try_lock()) {
+            return false;
+        }
+        mTracker.onAcquire();
+        mAcquiredAt = GLockTracker::now();
+        return true;
+    }
+
+    void unlock()
+    {
+        const int64_t holdNs = GLockTracker::now() - mAcquiredAt;
+        mLock.unlock();
+        mTracker.onRelease(holdNs);
+    }
+
+    LOCK &raw() noexcept
+    { return mLock; }
+
+private:
+    LOCK mLock;
+    int64_t mAcquiredAt = 0;    // Only touched by the owner
+    GLockTracker mTracker;
+};
+
+
+/**
+ * @class GProfiledRWLock
+ * @brief Reader/writer lock recording its acquisitions and waits, hold times are only measured for writers.
+ *
+ * @tparam RWLOCK Lock with readLock(), tryReadLock(), readUnlock(), writeLock(), tryWriteLock() and writeUnlock()
+ */
+template<typename RWLOCK>
+class GProfiledRWLock
+{
+public:
+    explicit GProfiledRWLock(const char *name = nullptr,
+                             const std::source_location &location = std::source_location::current()) noexcept
+        : mTracker(name, location)
+    {
+    }
+
+    ~GProfiledRWLock() = default;
+
+    GProfiledRWLock(const GProfiledRWLock &b) = delete;
+
+    GProfiledRWLock &operator=(const GProfiledRWLock &b) = delete;
+
+public:
+    void readLock()
+    {
+        if (mLock.tryReadLock()) {
+            mTracker.onAcquire();
+            return;
+        }
+        const int64_t t0 = GLockTracker::now();
+        mLock.readLock();
+        mTracker.onContendedAcquire(GLockTracker::now() - t0);
+    }
+
+    bool tryReadLock()
+    {
+        if (!mLock.tryReadLock()) {
+            return false;
+        }
+        mTracker.onAcquire();
+        return true;
+    }
+
+    void readUnlock()
+    {
+        mLock.readUnlock();
+    }
+
+    void writeLock()
+    {
+        if (mLock.tryWriteLock()) {
+            mTracker.onAcquire();
+            mAcquiredAt = GLockTracker::now();
+            return;
+        }
+        const int64_t t0 = GLockTracker::now();
+        mLock.writeLock();
+        mAcquiredAt = GLockTracker::now();
+        mTracker.onContendedAcquire(mAcquiredAt - t0);
+    }
+
+    bool tryWriteLock()
+    {
+        if (!mLock.tryWriteLock()) {
+            return false;
+        }
+        mTracker.onAcquire();
+        mAcquiredAt = GLockTracker::now();
+        return true;
+    }
+
+    void writeUnlock()
+    {
+        const int64_t holdNs = GLockTracker::now() - mAcquiredAt;
+        mLock.writeUnlock();
+        mTracker.onRelease(holdNs);
+    }
+
+    GRaii readGuard() noexcept
+    {
+        return gx::makeRAII(*this, &GProfiledRWLock::readUnlock, &GProfiledRWLock::readLock);
+    }
+
+    GRaii writeGuard() noexcept
+    {
+        return gx::makeRAII(*this, &GProfiledRWLock::writeUnlock, &GProfiledRWLock::writeLock);
+    }
+
+    RWLOCK &raw() noexcept
+    { return mLock; }
+
+private:
+    RWLOCK mLock;
+    int64_t mAcquiredAt = 0;    // Only touched by the writer
+    GLockTracker mTracker;
+};
+
+
+/**
+ * With GX_LOCK_PROFILING defined (the GX_LOCK_PROFILING CMake variable) every lock declared with the
+ * types below is profiled, without touching the code using them.
+ * GConditionVariable must then be used with GLocker<GMutex>, std::condition_variable only accepts a std::mutex.
+ */
+#if GX_LOCK_PROFILING
+
+using GMutex = GProfiledLock<std::mutex>;
+
+using GSpinLock = GProfiledLock<GRawSpinLock>;
+
+using GAdaptiveLock = GProfiledLock<GRawAdaptiveLock>;
+
+using GRWLock = GProfiledRWLock<GRawRWLock>;
+
+using GReaderBiasedRWLock = GProfiledRWLock<GRawReaderBiasedRWLock>;
+
+using GConditionVariable = std::condition_variable_any;
+
+#else
+
+using GMutex = std::mutex;
+
+using GSpinLock = GRawSpinLock;
+
+using GAdaptiveLock = GRawAdaptiveLock;
+
+using GRWLock = GRawRWLock;
+
+using GReaderBiasedRWLock = GRawReaderBiasedRWLock;
+
+using GConditionVariable = std::condition_variable;
+
+#endif
+
+
 template<class MUTEX>
 class GLockerGuard
 {
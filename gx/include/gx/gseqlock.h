@@ -0,0 +1,157 @@
+//
+// Created by Gxin on 2024/4/3.
+//
+
+#ifndef GX_GSEQLOCK_H
+#define GX_GSEQLOCK_H
+
+#include "gmutex.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+
+/**
+ * @class GSeqLock
+ * @brief Sequence lock publishing a small value, readers never write shared memory and never block the writer.
+ *
+ * The writer makes the sequence odd, writes the value and makes it even again,
+ * a reader copies the value and retries when the sequence was odd or moved meanwhile.
+ * The value is kept in relaxed atomic words, so the torn copy a reader may make and then discard is not a data race.
+ * Writers are serialized by the sequence itself, reads are only worth it while writes are rare.
+ *
+ * @tparam T Trivially copyable, a few cache lines at most
+ */
+template<typename T>
+class GSeqLock
+{
+    static_assert(std::is_trivially_copyable_v<T>, "GSeqLock requires a trivially copyable type");
+    static_assert(std::is_default_constructible_v<T>, "GSeqLock requires a default constructible type");
+
+public:
+    GSeqLock() noexcept
+            : GSeqLock(T{})
+    {
+    }
+
+    explicit GSeqLock(const T &value) noexcept
+    {
+        writeWords(value);
+    }
+
+    GSeqLock(const GSeqLock &) = delete;
+
+    GSeqLock &operator=(const GSeqLock &) = delete;
+
+public:
+    T load() const noexcept
+    {
+        Words words;
+        while (true) {
+            const uint32_t s0 = mSequence.load(std::memory_order_acquire);
+            if (s0 & 1) {
+                gx::cpuRelax();
+                continue;
+            }
+            for (size_t i = 0; i < WORD_COUNT; i++) {
+                words[i] = mWords[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (mSequence.load(std::memory_order_relaxed) == s0) {
+                break;
+            }
+        }
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+    void store(const T &value) noexcept
+    {
+        const uint32_t s = beginWrite();
+        writeWords(value);
+        mSequence.store(s + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Read-modify-write, func(T &) runs with the other writers excluded.
+     * If func throws the value is left unchanged and the lock is released before the exception propagates.
+     */
+    template<typename F>
+    void update(F &&func)
+    {
+        const uint32_t s = beginWrite();
+        T value = readWords();
+        try {
+            func(value);
+        } catch (...) {
+            // No word was written, an odd sequence left behind would block every reader and writer
+            mSequence.store(s + 2, std::memory_order_release);
+            throw;
+        }
+        writeWords(value);
+        mSequence.store(s + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Even, bumped by 2 on each store
+     */
+    uint32_t sequence() const noexcept
+    {
+        return mSequence.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr size_t WORD_COUNT = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    using Words = uint64_t[WORD_COUNT];
+
+    /**
+     * @return The even sequence the write started from, the sequence is now odd
+     */
+    uint32_t beginWrite() noexcept
+    {
+        uint32_t s = mSequence.load(std::memory_order_relaxed);
+        while (true) {
+            if (s & 1) {
+                gx::cpuRelax();
+                s = mSequence.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (mSequence.compare_exchange_weak(s, s + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        // The odd sequence must be visible before any of the new words
+        std::atomic_thread_fence(std::memory_order_release);
+        return s;
+    }
+
+    T readWords() const noexcept
+    {
+        Words words;
+        for (size_t i = 0; i < WORD_COUNT; i++) {
+            words[i] = mWords[i].load(std::memory_order_relaxed);
+        }
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+    void writeWords(const T &value) noexcept
+    {
+        Words words = {};
+        std::memcpy(words, &value, sizeof(T));
+        for (size_t i = 0; i < WORD_COUNT; i++) {
+            mWords[i].store(words[i], std::memory_order_relaxed);
+        }
+    }
+
+private:
+    std::atomic<uint32_t> mSequence{0};
+    std::atomic<uint64_t> mWords[WORD_COUNT];
+};
+
+#endif //GX_GSEQLOCK_H
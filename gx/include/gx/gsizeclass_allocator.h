@@ -0,0 +1,100 @@
+//
+// Created by Gxin on 2024/3/28.
+//
+
+#ifndef GX_GSIZECLASS_ALLOCATOR_H
+#define GX_GSIZECLASS_ALLOCATOR_H
+
+#include "allocator.h"
+
+
+/**
+ * @class GSizeClassAllocator
+ * @brief General purpose, thread safe allocator for variable size allocations, in the tcmalloc/mimalloc style.
+ *
+ * Small sizes (up to MAX_SMALL_SIZE) are rounded up to one of CLASS_COUNT size classes,
+ * each thread keeps a free list (magazine) per class and only takes the central depot lock
+ * to exchange a whole batch of objects. The objects are carved from SPAN_SIZE aligned spans
+ * whose header records the class, so free() does not need the size.
+ * Larger sizes, and alignments the classes can not honor, go straight to gx::alignedAlloc
+ * with SPAN_SIZE alignment, which is how free() tells the two apart.
+ *
+ * All instances share one process wide heap, the allocator itself is stateless like GHeapAllocator,
+ * so GArena<GSizeClassAllocator, GLockingPolicy::NoLock> is safe to use from several threads.
+ * Spans are kept for reuse and never returned to the system.
+ */
+class GX_API GSizeClassAllocator
+{
+public:
+    static constexpr size_t SPAN_SIZE = 128 * 1024;
+    static constexpr size_t MAX_SMALL_SIZE = 16 * 1024;
+    static constexpr size_t MIN_ALIGNMENT = 16;
+    static constexpr size_t MAX_CLASS_ALIGNMENT = 256;
+    static constexpr int32_t CLASS_COUNT = 36;
+
+    struct Stats
+    {
+        size_t reservedBytes = 0;   ///< Memory held in spans
+        size_t depotBytes = 0;      ///< Free objects parked in the central depot
+        uint64_t largeAllocs = 0;   ///< Allocations served by gx::alignedAlloc
+    };
+
+public:
+    GSizeClassAllocator() noexcept = default;
+
+    template<typename AREA>
+    explicit GSizeClassAllocator(const AREA &)
+    {}
+
+    GSizeClassAllocator(const GSizeClassAllocator &rhs) = delete;
+
+    GSizeClassAllocator &operator=(const GSizeClassAllocator &rhs) = delete;
+
+    GSizeClassAllocator(GSizeClassAllocator &&rhs) noexcept = default;
+
+    GSizeClassAllocator &operator=(GSizeClassAllocator &&rhs) noexcept = default;
+
+    ~GSizeClassAllocator() noexcept = default;
+
+public:
+    void *alloc(size_t size, size_t alignment = alignof(std::max_align_t), size_t extra = 0);
+
+    void free(void *p) noexcept;
+
+    void free(void *p, size_t) noexcept
+    {
+        this->free(p);
+    }
+
+    void swap(GSizeClassAllocator &) noexcept
+    {}
+
+    size_t size() const noexcept
+    {
+        return 0;
+    }
+
+    size_t capacity() const noexcept
+    {
+        return stats().reservedBytes;
+    }
+
+public:
+    /**
+     * @return Size class used for the request, -1 if it is served by gx::alignedAlloc
+     */
+    static int32_t sizeClass(size_t size, size_t alignment = MIN_ALIGNMENT) noexcept;
+
+    static size_t classSize(int32_t sizeClass) noexcept;
+
+    /**
+     * @brief Return the free objects cached by the calling thread to the central depot
+     */
+    static void flushThreadCache() noexcept;
+
+    static Stats stats() noexcept;
+};
+
+using GSizeClassArena = GArena<GSizeClassAllocator, GLockingPolicy::NoLock>;
+
+#endif //GX_GSIZECLASS_ALLOCATOR_H
@@ -0,0 +1,271 @@
+//
+// Created by Gxin on 2024/4/1.
+//
+
+#ifndef GX_GSLOTMAP_H
+#define GX_GSLOTMAP_H
+
+#include "gx/gglobal.h"
+
+#include "debug.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+/**
+ * @class GSlotMap
+ * @brief Generational slot map, stable handles over densely packed values.
+ *
+ * A handle packs a slot index (low INDEX_BITS) and the generation of the slot (high bits),
+ * the slot points at the value in a packed array, so insert, erase and lookup are O(1)
+ * and iterating over the values walks contiguous memory.
+ * Erasing moves the last value into the hole, pointers and iteration order are not stable, handles are.
+ * The generation of a slot is bumped on erase, a stale handle no longer matches and get() returns nullptr.
+ * A slot reaching MAX_GENERATION is retired instead of being reused.
+ * The null handle is 0, the generations start at 1.
+ *
+ * @tparam T
+ * @tparam HANDLE       uint32_t or uint64_t
+ * @tparam INDEX_BITS   Bits of the slot index, the remaining bits hold the generation
+ */
+template<typename T, typename HANDLE = uint64_t, int INDEX_BITS = sizeof(HANDLE) == 4 ? 20 : 32>
+class GSlotMap
+{
+    static_assert(std::is_unsigned_v<HANDLE>, "HANDLE must be an unsigned integer");
+    static_assert(INDEX_BITS > 0 && INDEX_BITS < static_cast<int>(sizeof(HANDLE) * 8) && INDEX_BITS <= 32,
+                  "INDEX_BITS must leave room for the generation");
+
+public:
+    using Handle = HANDLE;
+    using Iterator = typename std::vector<T>::iterator;
+    using ConstIterator = typename std::vector<T>::const_iterator;
+
+    static constexpr Handle NULL_HANDLE = 0;
+    static constexpr uint64_t MAX_SIZE = (uint64_t(1) << INDEX_BITS) - 1;
+    static constexpr Handle MAX_GENERATION = std::numeric_limits<Handle>::max() >> INDEX_BITS;
+
+public:
+    GSlotMap() = default;
+
+    GSlotMap(const GSlotMap &) = default;
+
+    GSlotMap(GSlotMap &&) noexcept = default;
+
+    GSlotMap &operator=(const GSlotMap &) = default;
+
+    GSlotMap &operator=(GSlotMap &&) noexcept = default;
+
+public:
+    /**
+     * @return NULL_HANDLE when every index is in use
+     */
+    template<typename... ARGS>
+    Handle emplace(ARGS &&... args)
+    {
+        if (mFreeHead == NONE && mSlots.size() >= MAX_SIZE) {
+            return NULL_HANDLE;
+        }
+        // Whatever may throw comes before a slot is taken, the containers stay in sync if it does
+        growForOne(mValueSlots);
+        if (mFreeHead == NONE) {
+            growForOne(mSlots);
+        }
+        mValues.emplace_back(std::forward<ARGS>(args)...);
+
+        uint32_t index;
+        if (mFreeHead != NONE) {
+            index = mFreeHead;
+            mFreeHead = mSlots[index].link;
+        } else {
+            index = static_cast<uint32_t>(mSlots.size());
+            mSlots.push_back({1, NONE});
+        }
+        Slot &slot = mSlots[index];
+        slot.link = static_cast<uint32_t>(mValues.size() - 1);
+        mValueSlots.push_back(index);
+        return makeHandle(index, slot.generation);
+    }
+
+    Handle insert(const T &value)
+    {
+        return emplace(value);
+    }
+
+    Handle insert(T &&value)
+    {
+        return emplace(std::move(value));
+    }
+
+    /**
+     * @return false if the handle is stale or null
+     */
+    bool erase(Handle handle)
+    {
+        if (!isLive(handle)) {
+            return false;
+        }
+        const uint32_t index = indexOf(handle);
+        const uint32_t valueIndex = mSlots[index].link;
+        const uint32_t last = static_cast<uint32_t>(mValues.size() - 1);
+        if (valueIndex != last) {
+            mValues[valueIndex] = std::move(mValues[last]);
+            mValueSlots[valueIndex] = mValueSlots[last];
+            mSlots[mValueSlots[valueIndex]].link = valueIndex;
+        }
+        mValues.pop_back();
+        mValueSlots.pop_back();
+        releaseSlot(index);
+        return true;
+    }
+
+    T *get(Handle handle) noexcept
+    {
+        return isLive(handle) ? &mValues[mSlots[indexOf(handle)].link] : nullptr;
+    }
+
+    const T *get(Handle handle) const noexcept
+    {
+        return isLive(handle) ? &mValues[mSlots[indexOf(handle)].link] : nullptr;
+    }
+
+    bool contains(Handle handle) const noexcept
+    {
+        return isLive(handle);
+    }
+
+    T &operator[](Handle handle) noexcept
+    {
+        GX_ASSERT(isLive(handle));
+        return mValues[mSlots[indexOf(handle)].link];
+    }
+
+    const T &operator[](Handle handle) const noexcept
+    {
+        GX_ASSERT(isLive(handle));
+        return mValues[mSlots[indexOf(handle)].link];
+    }
+
+    /**
+     * @brief Handle of the value at a position of the packed array, to go back from an iteration
+     */
+    Handle handleAt(size_t valueIndex) const noexcept
+    {
+        GX_ASSERT(valueIndex < mValues.size());
+        const uint32_t index = mValueSlots[valueIndex];
+        return makeHandle(index, mSlots[index].generation);
+    }
+
+    /**
+     * @brief Erase every value, the outstanding handles all become stale
+     */
+    void clear()
+    {
+        for (const uint32_t index: mValueSlots) {
+            releaseSlot(index);
+        }
+        mValues.clear();
+        mValueSlots.clear();
+    }
+
+    void reserve(size_t count)
+    {
+        mSlots.reserve(count);
+        mValues.reserve(count);
+        mValueSlots.reserve(count);
+    }
+
+    size_t size() const noexcept
+    { return mValues.size(); }
+
+    bool empty() const noexcept
+    { return mValues.empty(); }
+
+    T *data() noexcept
+    { return mValues.data(); }
+
+    const T *data() const noexcept
+    { return mValues.data(); }
+
+    Iterator begin() noexcept
+    { return mValues.begin(); }
+
+    Iterator end() noexcept
+    { return mValues.end(); }
+
+    ConstIterator begin() const noexcept
+    { return mValues.begin(); }
+
+    ConstIterator end() const noexcept
+    { return mValues.end(); }
+
+public:
+    static constexpr uint32_t indexOf(Handle handle) noexcept
+    {
+        return static_cast<uint32_t>(handle & static_cast<Handle>(MAX_SIZE));
+    }
+
+    static constexpr Handle generationOf(Handle handle) noexcept
+    {
+        return handle >> INDEX_BITS;
+    }
+
+private:
+    static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+    struct Slot
+    {
+        Handle generation;
+        uint32_t link;      // Index in mValues when live, next free slot otherwise
+    };
+
+    static constexpr Handle makeHandle(uint32_t index, Handle generation) noexcept
+    {
+        return (generation << INDEX_BITS) | static_cast<Handle>(index);
+    }
+
+    /**
+     * @brief Make room for one more element, growing geometrically, so the next push_back cannot throw
+     */
+    template<typename V>
+    static void growForOne(std::vector<V> &v)
+    {
+        if (v.size() == v.capacity()) {
+            v.reserve(std::max<size_t>(v.capacity() * 2, 8));
+        }
+    }
+
+    /**
+     * @brief A free slot is one generation ahead of its last handle, a retired one sits at MAX_GENERATION
+     * which no handle carries, so only the live slots match
+     */
+    bool isLive(Handle handle) const noexcept
+    {
+        const uint32_t index = indexOf(handle);
+        return index < mSlots.size() && mSlots[index].generation == generationOf(handle);
+    }
+
+    void releaseSlot(uint32_t index) noexcept
+    {
+        Slot &slot = mSlots[index];
+        if (++slot.generation == MAX_GENERATION) {
+            // Retired, reusing it would make the oldest handles valid again
+            slot.link = NONE;
+            return;
+        }
+        slot.link = mFreeHead;
+        mFreeHead = index;
+    }
+
+private:
+    std::vector<Slot> mSlots;
+    std::vector<T> mValues;
+    std::vector<uint32_t> mValueSlots;  // Slot of each value, parallel to mValues
+    uint32_t mFreeHead = NONE;
+};
+
+#endif //GX_GSLOTMAP_H
@@ -10,6 +10,7 @@
 #include "gthread.h"
 #include "gmutex.h"
 #include "gtimer.h"
+#include "ghistogram.h"
 
 #include <atomic>
 #include <future>
@@ -109,6 +110,28 @@ public:
         std::shared_ptr<std::atomic<bool> > mActive;
     };
 
+    /**
+     * @brief Priority class of a task, submit() queues Normal tasks, submitFront() queues High tasks
+     */
+    enum class TaskPriority : uint8_t
+    {
+        Normal = 0,
+        High = 1,
+    };
+
+    static constexpr size_t TASK_PRIORITY_COUNT = 2;
+
+    /**
+     * @brief Latency statistics in nanoseconds.
+     * waitTime: from enqueue to the start of execution;
+     * execTime: execution time of the task function.
+     */
+    struct TaskStats
+    {
+        GHistogram::Snapshot waitTime;
+        GHistogram::Snapshot execTime;
+    };
+
 public:
     /**
      * Construct Task System
@@ -204,6 +227,35 @@ public:
 
     uint64_t waitingTaskCount() const;
 
+    /**
+     * @brief Enable or disable recording of wait/exec time, enabled by default
+     * @param enabled
+     */
+    void setStatsEnabled(bool enabled);
+
+    bool isStatsEnabled() const;
+
+    /**
+     * @brief Get the statistics of all tasks
+     * @return
+     */
+    TaskStats taskStats() const;
+
+    /**
+     * @brief Get the statistics of tasks of the specified priority class
+     * @param priority
+     * @return
+     */
+    TaskStats taskStats(TaskPriority priority) const;
+
+    /**
+     * @brief Get the statistics of all tasks and start a new measurement period
+     * @return
+     */
+    TaskStats takeTaskStats();
+
+    void resetTaskStats();
+
 private:
     using TaskFunc = std::function<void()>;
 
@@ -211,6 +263,14 @@ private:
     {
         TaskFunc func;
         std::shared_ptr<std::atomic<bool> > active;
+        int64_t enqueueTime = 0;
+        TaskPriority priority = TaskPriority::Normal;
+    };
+
+    struct PriorityStats
+    {
+        GHistogram waitTime;
+        GHistogram execTime;
     };
 
     TaskFuncRef pushTask(const TaskFunc &task);
@@ -219,6 +279,8 @@ private:
 
     void clearTask();
 
+    void runTask(const TaskFuncRef &taskFuncRef);
+
 private:
     std::string mName;
 
@@ -229,8 +291,11 @@ private:
     std::list<TaskFuncRef> mTaskQueue;
 
     mutable GMutex mLock;
-    std::condition_variable mTaskCond;
+    GConditionVariable mTaskCond;
     std::atomic<bool> mIsRunning{false};
+
+    std::atomic<bool> mStatsEnabled{true};
+    std::unique_ptr<PriorityStats[]> mStats;
 };
 
 #endif //GX_TASK_SYSTEM_H
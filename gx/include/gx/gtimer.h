@@ -11,47 +11,189 @@
 #include "gmutex.h"
 
 #include <functional>
-#include <queue>
+#include <memory>
 #include <vector>
 
 
 using GTimerEvent = std::function<void()>;
 using GTimerCondition = std::function<bool()>;
 
+/**
+ * @brief Timer event receiving the number of missed ticks, see GTimerMissedTickPolicy
+ */
+using GTimerTickEvent = std::function<void(int64_t missedTicks)>;
+
+/**
+ * @brief How the next deadline of a periodic timer is computed
+ */
+enum class GTimerSchedule
+{
+    FixedDelay, ///< next = end of the previous run + interval, callback latency accumulates as drift
+    FixedRate,  ///< next = previous deadline + interval, stays aligned to the start time
+};
+
+/**
+ * @brief What a fixed-rate timer does when it falls one or more whole intervals behind
+ */
+enum class GTimerMissedTickPolicy
+{
+    FireAll,    ///< Run once for every tick, back to back, missedTicks = ticks still overdue behind this run
+    Coalesce,   ///< Run once now for all overdue ticks, missedTicks = ticks merged into this run
+    Skip,       ///< Drop the overdue ticks and run at the next aligned tick, missedTicks = ticks dropped before it
+};
+
+/**
+ * @brief Runs an expired timer event away from the scheduler thread, must not block.
+ * See GTimerScheduler::executorOf() for GTaskSystem and GJobSystem.
+ */
+using GTimerExecutor = std::function<void(std::function<void()> run)>;
+
+/**
+ * @brief How the runs of one timer dispatched to an executor relate to each other.
+ * Fixed-delay timers are re-armed after their run finishes, so their runs never overlap whatever the mode.
+ */
+enum class GTimerConcurrency
+{
+    Serial,         ///< Runs never overlap and start in firing order, a run that fires while another is executing is queued
+    SkipOverlap,    ///< Runs never overlap, a run that fires while another is executing is dropped and counted as missed ticks
+    Parallel,       ///< Runs may overlap on different executor threads, no ordering between them
+};
+
+class GTimerScheduler;
+
+class GTimerQueue;
+
+class GTaskSystem;
+
+class GJobSystem;
+
+class GTimerWaiter;
+
 /**
  * @class GTimerTask
  */
 class GX_API GTimerTask
 {
 private:
+    /**
+     * @param delay     Nanoseconds
+     * @param interval  Nanoseconds
+     */
     explicit GTimerTask(GTimerEvent event, GTimerCondition condition, int64_t delay, int64_t interval);
 
 public:
+    /**
+     * @brief Cancel the task, the task will be removed from the scheduler immediately if the backend supports it
+     */
     void cancel();
 
+private:
+    /**
+     * @brief Wait until the runs that have already started are over, a run of this task on the calling thread is not waited for
+     */
+    void waitRuns();
+
 private:
     friend class GTimer;
 
     friend class GTimerScheduler;
 
+    friend class GTimerQueue;
+
+    friend class GTimerHeapQueue;
+
+    friend class GTimerWheelQueue;
+
+    // Replaced by cancel() and GTimer while runs read them, guarded by mRunLock
     GTimerEvent mEvent;
+    GTimerTickEvent mTickEvent;
     GTimerCondition mCondition;
     int64_t mInterval;
     GTime mTime;
     std::atomic_bool mValid;
     bool mOneShot{false};
+    GTimerSchedule mSchedule = GTimerSchedule::FixedDelay;
+    GTimerMissedTickPolicy mMissedTickPolicy = GTimerMissedTickPolicy::FireAll;
+    int64_t mSkippedTicks = 0;
+    int64_t mSlack = 0;
+
+    std::weak_ptr<GTimerScheduler> mScheduler;
+
+    // Runs handed to an executor, see GTimerConcurrency
+    GTimerExecutor mExecutor;
+    GTimerConcurrency mConcurrency = GTimerConcurrency::Serial;
+    GSpinLock mRunLock;
+    std::vector<int64_t> mPendingRuns;
+    bool mRunning = false;
+    std::atomic<int32_t> mInFlight{0};
+
+    // Queue bookkeeping, owned by the backend
+    std::shared_ptr<GTimerTask> mQueueRef;
+    GTimerTask *mPrev = nullptr;
+    GTimerTask *mNext = nullptr;
+    int32_t mSlot = -1;
+    int64_t mExpireTick = 0;
 };
 
-class GX_API GTimerScheduler
+class GX_API GTimerScheduler : public std::enable_shared_from_this<GTimerScheduler>
 {
 public:
     using GTimerTaskPtr = std::shared_ptr<GTimerTask>;
 
+    /**
+     * @brief Data structure used to keep the pending tasks
+     */
+    enum class Backend
+    {
+        Heap,   ///< Binary heap, O(log n) insert and expire
+        Wheel,  ///< Hierarchical timing wheel, O(1) insert, cancel and expire, resolution of Options::wheelTick
+    };
+
+    /**
+     * @brief How the scheduler thread sleeps until the next deadline in run()
+     */
+    enum class WaitMode
+    {
+        Default,    ///< Condition variable with an absolute steady clock deadline
+        Precise,    ///< timerfd on Linux (condition variable elsewhere), not affected by timer slack
+    };
+
+    struct Options
+    {
+        Backend backend = Backend::Heap;
+        int64_t wheelTick = 1000000;    ///< Tick of the wheel backend, in nanoseconds
+        WaitMode waitMode = WaitMode::Default;
+        int64_t spinTime = 0;           ///< Busy wait this many nanoseconds before each deadline instead of sleeping
+        GTimerExecutor executor;        ///< Default executor of the events, empty to run them on the scheduler thread
+    };
+
+    /**
+     * @brief Wakeups of the scheduler thread, see GTimer::setSlack()
+     */
+    struct WakeupStats
+    {
+        uint64_t wakeups = 0;       ///< Times the scheduler thread woke up (run()) or loop() was called
+        uint64_t firedTasks = 0;    ///< Expired tasks handled in these wakeups
+        double seconds = 0;         ///< Time covered by the statistics
+
+        double wakeupsPerSecond() const
+        {
+            return seconds > 0 ? static_cast<double>(wakeups) / seconds : 0;
+        }
+
+        double tasksPerWakeup() const
+        {
+            return wakeups > 0 ? static_cast<double>(firedTasks) / static_cast<double>(wakeups) : 0;
+        }
+    };
+
 private:
-    explicit GTimerScheduler(std::string name);
+    explicit GTimerScheduler(std::string name, const Options &options);
 
 public:
-    static std::shared_ptr<GTimerScheduler> create(std::string name);
+    static std::shared_ptr<GTimerScheduler> create(std::string name, Backend backend = Backend::Heap);
+
+    static std::shared_ptr<GTimerScheduler> create(std::string name, const Options &options);
 
     static void makeGlobal(const std::shared_ptr<GTimerScheduler> &obj);
 
@@ -84,34 +226,100 @@ public:
     /**
      * @brief Push a one-time scheduled task
      * @param event
-     * @param delay
+     * @param delay     Milliseconds
      */
     GTimerTaskPtr post(GTimerEvent event, int64_t delay);
 
+    GTimerTaskPtr postMicroSecs(GTimerEvent event, int64_t delay);
+
+    GTimerTaskPtr postNanoSecs(GTimerEvent event, int64_t delay);
+
+    Backend backend() const;
+
+    /**
+     * @brief Number of live tasks waiting in the scheduler
+     */
+    size_t taskCount() const;
+
+    /**
+     * @brief Number of cancelled tasks still held by the scheduler, waiting to be compacted
+     */
+    size_t deadTaskCount() const;
+
+    WakeupStats wakeupStats() const;
+
+    /**
+     * @brief Return the statistics and start a new measurement period
+     */
+    WakeupStats takeWakeupStats();
+
+    void resetWakeupStats();
+
+    /**
+     * @brief Executor submitting the events to a task system, the task system must outlive the scheduler
+     * @param taskSystem
+     * @param front     Queue the events with GTaskSystem::submitFront(), they overtake queued work but run newest first
+     */
+    static GTimerExecutor executorOf(GTaskSystem *taskSystem, bool front = false);
+
+    /**
+     * @brief Executor running the events as jobs, the job system must outlive the scheduler.
+     * The thread driving the scheduler is adopted by the job system, which needs a free adoptable thread for it.
+     */
+    static GTimerExecutor executorOf(GJobSystem *jobSystem);
+
 private:
     GTimerTaskPtr addTask(GTimerEvent event, GTimerCondition condition, int64_t delay, int64_t interval, bool oneShot);
 
+    void scheduleTask(const GTimerTaskPtr &task);
+
+    void removeTask(GTimerTask *task);
+
+    /**
+     * @brief Put a periodic task back into the queue
+     * @param task
+     * @param ticks Number of intervals to advance a fixed-rate deadline by
+     */
+    void pushTask(const GTimerTaskPtr &task, int64_t ticks, bool notify = false);
+
+    void executeTask(const GTimerTaskPtr &task);
+
+    /**
+     * @return false if the run was dropped by GTimerConcurrency::SkipOverlap
+     */
+    bool dispatchTask(const GTimerTaskPtr &task, const GTimerExecutor &executor, int64_t missedTicks);
+
+    static void drainTask(const GTimerTaskPtr &task, const GTimerExecutor &executor, const GTimerEvent &finish);
+
+    static void runTask(const GTimerTaskPtr &task, int64_t missedTicks);
+
 private:
     friend class GTimer;
 
+    friend class GTimerTask;
+
     std::string mName;
+    const Backend mBackend;
 
     mutable GMutex mLock;
-    std::condition_variable mTaskCond;
     std::atomic<bool> mIsRunning{false};
 
-    using CompFunc = std::function<bool(const GTimerTaskPtr &, const GTimerTaskPtr &)>;
+    std::unique_ptr<GTimerQueue> mTaskQueue;
+    std::unique_ptr<GTimerWaiter> mWaiter;
+    const GTimerExecutor mExecutor;
 
-    std::priority_queue<GTimerTaskPtr, std::vector<GTimerTaskPtr>, CompFunc> mTaskQueue{
-        [](const GTimerTaskPtr &lhs, const GTimerTaskPtr &rhs) {
-            return lhs->mTime > rhs->mTime;
-        }
-    };
+    std::atomic<uint64_t> mWakeups{0};
+    std::atomic<uint64_t> mFiredTasks{0};
+    std::atomic<int64_t> mStatsBeginTime;
 };
 
 using GTimerSchedulerPtr = std::shared_ptr<GTimerScheduler>;
 
 
+/**
+ * @brief stop() and the destructor wait for the event runs in progress. A subclass overriding timeout()
+ * or condition() must call stop() in its own destructor, the base destructor runs after the override is gone.
+ */
 class GX_API GTimer : public GObject
 {
 public:
@@ -136,22 +344,79 @@ public:
 
     void timerEvent(GTimerEvent event);
 
+    /**
+     * @brief Set an event that receives the number of missed ticks, replaces the event set by timerEvent()
+     * @param event
+     */
+    void timerTickEvent(GTimerTickEvent event);
+
     void setCondition(GTimerCondition cond);
 
     void setOneShot(bool oneShot = true);
 
+    /**
+     * @brief Takes effect on the next start()
+     * @param schedule
+     */
+    void setSchedule(GTimerSchedule schedule);
+
+    /**
+     * @brief Only used by GTimerSchedule::FixedRate, takes effect on the next start()
+     * @param policy
+     */
+    void setMissedTickPolicy(GTimerMissedTickPolicy policy);
+
+    /**
+     * @brief Allow the timer to fire up to slack later than its deadline, takes effect on the next start().
+     * The scheduler expires the timers whose windows overlap in a single wakeup, like Linux timer slack,
+     * which cuts wakeups when many timers have nearby deadlines. Fixed-rate deadlines stay on their grid.
+     * @param slack Milliseconds
+     */
+    void setSlack(int64_t slack);
+
+    void setSlackMicroSecs(int64_t slack);
+
+    void setSlackNanoSecs(int64_t slack);
+
+    /**
+     * @brief Run the events on an executor instead of the scheduler's default, takes effect on the next start().
+     * The condition is still checked on the scheduler thread. stop() waits for the runs that have already started
+     * and drops the dispatched runs that have not, unless it is called from the timer's own event.
+     * @param executor      Empty to use the scheduler's default
+     * @param concurrency
+     */
+    void setExecutor(GTimerExecutor executor, GTimerConcurrency concurrency = GTimerConcurrency::Serial);
+
+    /**
+     * @brief Start the timer
+     * @param interval  Milliseconds
+     */
     void start(int64_t interval);
 
     void start(int64_t delay, int64_t interval);
 
+    void startMicroSecs(int64_t interval);
+
+    void startMicroSecs(int64_t delay, int64_t interval);
+
+    void startNanoSecs(int64_t interval);
+
+    void startNanoSecs(int64_t delay, int64_t interval);
+
     void stop();
 
 private:
     std::weak_ptr<GTimerScheduler> mScheduler;
     GTimerEvent mEvent;
+    GTimerTickEvent mTickEvent;
     GTimerCondition mCondition;
     std::weak_ptr<GTimerTask> mTask;
     bool mOneShot{false};
+    GTimerSchedule mSchedule = GTimerSchedule::FixedDelay;
+    GTimerMissedTickPolicy mMissedTickPolicy = GTimerMissedTickPolicy::FireAll;
+    GTimerExecutor mExecutor;
+    GTimerConcurrency mConcurrency = GTimerConcurrency::Serial;
+    int64_t mSlack = 0;
 };
 
 #endif //GX_GTIMER_H
@@ -0,0 +1,320 @@
+//
+// Created by Gxin on 2024/3/30.
+//
+
+#include "gx/allocator.h"
+
+#include <algorithm>
+#include <cerrno>
+
+#if GX_PLATFORM_WINDOWS
+
+#include <windows.h>
+
+#else
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#endif
+
+#if GX_PLATFORM_LINUX || GX_PLATFORM_ANDROID
+
+#include <sys/syscall.h>
+
+#endif
+
+
+namespace
+{
+
+struct Registry
+{
+    GMutex lock;
+    std::vector<GArenaTracker *> trackers;
+};
+
+Registry &registry()
+{
+    // Never destroyed, static arenas may unregister after the other statics are gone
+    static auto *registry = new Registry();
+    return *registry;
+}
+
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+size_t pageSize() noexcept
+{
+#if GX_PLATFORM_WINDOWS
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+#else
+    return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+#if GX_PLATFORM_WINDOWS
+
+void *virtualAlloc(size_t size, DWORD flags, int32_t numaNode) noexcept
+{
+    if (numaNode >= 0) {
+        return VirtualAllocExNuma(GetCurrentProcess(), nullptr, size, flags, PAGE_READWRITE, numaNode);
+    }
+    return VirtualAlloc(nullptr, size, flags, PAGE_READWRITE);
+}
+
+#else
+
+void *mapAnonymous(size_t size, int flags) noexcept
+{
+    void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+}
+
+#endif
+
+/**
+ * Preferred placement of the range on a NUMA node, must happen before the pages are faulted in
+ */
+void bindToNode(void *p, size_t size, int32_t node) noexcept
+{
+#if (GX_PLATFORM_LINUX || GX_PLATFORM_ANDROID) && defined(SYS_mbind)
+    constexpr int MPOL_PREFERRED_MODE = 1;
+    constexpr size_t BITS = sizeof(unsigned long) * 8;
+    unsigned long nodeMask[4] = {};
+    if (node >= static_cast<int32_t>(BITS * 4)) {
+        return;
+    }
+    nodeMask[node / BITS] |= 1UL << (node % BITS);
+    if (syscall(SYS_mbind, p, size, MPOL_PREFERRED_MODE, nodeMask, BITS * 4 + 1, 0) != 0) {
+        LogW("GMmapArea: mbind to NUMA node {} failed, errno = {}", node, errno);
+    }
+#endif
+}
+
+/**
+ * Fault in the pages of the range without changing their content, the range may already be in use
+ */
+void populate(void *p, size_t size) noexcept
+{
+#if GX_PLATFORM_LINUX || GX_PLATFORM_ANDROID
+    constexpr int MADV_POPULATE_WRITE_ADVICE = 23;  // Linux 5.14
+    if (madvise(p, size, MADV_POPULATE_WRITE_ADVICE) == 0) {
+        return;
+    }
+#endif
+    const size_t step = pageSize();
+    for (size_t i = 0; i < size; i += step) {
+        std::atomic_ref<char>(static_cast<char *>(p)[i]).fetch_or(0, std::memory_order_relaxed);
+    }
+}
+
+}
+
+GArenaTracker::GArenaTracker(const char *name) noexcept
+        : mName(name)
+{
+    GArenaRegistry::add(this);
+}
+
+GArenaTracker::~GArenaTracker() noexcept
+{
+    GArenaRegistry::remove(this);
+}
+
+GArenaStats GArenaTracker::stats() const noexcept
+{
+    GArenaStats stats;
+    stats.name = mName;
+    stats.currentBytes = mCurrentBytes.load(std::memory_order_relaxed);
+    stats.peakBytes = mPeakBytes.load(std::memory_order_relaxed);
+    stats.allocCount = mAllocCount.load(std::memory_order_relaxed);
+    stats.freeCount = mFreeCount.load(std::memory_order_relaxed);
+    stats.failedAllocs = mFailedAllocs.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void GArenaTracker::swapCounters(GArenaTracker &rhs) noexcept
+{
+    const auto swapAtomic = [](auto &a, auto &b) {
+        const auto v = a.load(std::memory_order_relaxed);
+        a.store(b.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        b.store(v, std::memory_order_relaxed);
+    };
+    // The trackers stay registered at their address, only the content moves
+    GLockerGuard locker(registry().lock);
+    std::swap(mName, rhs.mName);
+    swapAtomic(mCurrentBytes, rhs.mCurrentBytes);
+    swapAtomic(mPeakBytes, rhs.mPeakBytes);
+    swapAtomic(mAllocCount, rhs.mAllocCount);
+    swapAtomic(mFreeCount, rhs.mFreeCount);
+    swapAtomic(mFailedAllocs, rhs.mFailedAllocs);
+}
+
+std::vector<GArenaStats> GArenaRegistry::snapshot()
+{
+    Registry &r = registry();
+    GLockerGuard locker(r.lock);
+    std::vector<GArenaStats> result;
+    result.reserve(r.trackers.size());
+    for (const GArenaTracker *tracker: r.trackers) {
+        result.push_back(tracker->stats());
+    }
+    return result;
+}
+
+void GArenaRegistry::dump()
+{
+    const auto arenas = snapshot();
+    Log("Tracked arenas: {}", arenas.size());
+    for (const auto &s: arenas) {
+        Log("  {}: current = {} bytes, peak = {} bytes, allocs = {}, frees = {}, failed = {}",
+            s.name ? s.name : "", s.currentBytes, s.peakBytes, s.allocCount, s.freeCount, s.failedAllocs);
+    }
+}
+
+void GArenaRegistry::add(GArenaTracker *tracker)
+{
+    Registry &r = registry();
+    GLockerGuard locker(r.lock);
+    tracker->mRegistryIndex = r.trackers.size();
+    r.trackers.push_back(tracker);
+}
+
+void GArenaRegistry::remove(GArenaTracker *tracker)
+{
+    Registry &r = registry();
+    GLockerGuard locker(r.lock);
+    const size_t index = tracker->mRegistryIndex;
+    if (index >= r.trackers.size() || r.trackers[index] != tracker) {
+        return;
+    }
+    // The order does not matter, the last tracker takes the freed position
+    GArenaTracker *last = r.trackers.back();
+    r.trackers[index] = last;
+    last->mRegistryIndex = index;
+    r.trackers.pop_back();
+}
+
+GMmapArea::GMmapArea(size_t size, const Options &options)
+{
+    if (size == 0) {
+        return;
+    }
+    size = pointer::alignSize(size, pageSize());
+    bool populated = false;
+
+#if GX_PLATFORM_WINDOWS
+    // Large pages are always committed and locked, they need the SeLockMemoryPrivilege
+    const size_t largePage = GetLargePageMinimum();
+    if (options.hugePages == HugePages::Explicit && largePage) {
+        const size_t largeSize = pointer::alignSize(size, largePage);
+        mMapping = virtualAlloc(largeSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, options.numaNode);
+        if (mMapping) {
+            mMappingSize = largeSize;
+            mHugePages = true;
+            populated = true;
+        }
+    }
+    if (!mMapping) {
+        // Committed up front, a reserved only page faults on access and the allocators do not call commit()
+        mMapping = virtualAlloc(size, MEM_RESERVE | MEM_COMMIT, options.numaNode);
+        mMappingSize = size;
+    }
+    if (!mMapping) {
+        LogE("GMmapArea: VirtualAlloc of {} bytes failed, error = {}", size, GetLastError());
+        return;
+    }
+    mBegin = mMapping;
+#else
+    // Pages are faulted in after mbind when a node is requested
+    const bool populateAtMap = options.populate && options.numaNode < 0;
+    HugePages hugePages = options.hugePages;
+#   ifdef MAP_HUGETLB
+    if (hugePages == HugePages::Explicit) {
+        const size_t hugeSize = pointer::alignSize(size, HUGE_PAGE_SIZE);
+        int flags = MAP_HUGETLB;
+#       ifdef MAP_POPULATE
+        flags |= populateAtMap ? MAP_POPULATE : 0;
+        populated = populateAtMap;
+#       endif
+        mMapping = mapAnonymous(hugeSize, flags);
+        if (mMapping) {
+            mMappingSize = hugeSize;
+            mBegin = mMapping;
+            mHugePages = true;
+        } else {
+            // The huge page pool is empty or not configured
+            hugePages = HugePages::Transparent;
+            populated = false;
+        }
+    }
+#   else
+    if (hugePages == HugePages::Explicit) {
+        hugePages = HugePages::Transparent;
+    }
+#   endif
+    if (!mMapping) {
+        // Transparent huge pages need a huge page aligned range, map more and align inside
+        const size_t slack = hugePages == HugePages::Transparent ? HUGE_PAGE_SIZE : 0;
+        int flags = 0;
+#   ifdef MAP_NORESERVE
+        flags |= MAP_NORESERVE;
+#   endif
+#   ifdef MAP_POPULATE
+        // With transparent huge pages the advice has to come first
+        if (populateAtMap && !slack) {
+            flags |= MAP_POPULATE;
+            populated = true;
+        }
+#   endif
+        mMapping = mapAnonymous(size + slack, flags);
+        if (!mMapping) {
+            LogE("GMmapArea: mmap of {} bytes failed, errno = {}", size + slack, errno);
+            return;
+        }
+        mMappingSize = size + slack;
+        mBegin = slack ? pointer::align(mMapping, slack) : mMapping;
+#   ifdef MADV_HUGEPAGE
+        if (slack) {
+            mHugePages = madvise(mBegin, size, MADV_HUGEPAGE) == 0;
+        }
+#   endif
+    }
+#endif
+    mEnd = pointer::add(mBegin, size);
+
+    if (options.numaNode >= 0) {
+        bindToNode(mBegin, size, options.numaNode);
+    }
+    if (populated) {
+        mCommitted = size;
+    } else if (options.populate) {
+        commit(size);
+    } else if (options.commitSize) {
+        commit(options.commitSize);
+    }
+}
+
+GMmapArea::~GMmapArea() noexcept
+{
+    if (!mMapping) {
+        return;
+    }
+#if GX_PLATFORM_WINDOWS
+    VirtualFree(mMapping, 0, MEM_RELEASE);
+#else
+    munmap(mMapping, mMappingSize);
+#endif
+}
+
+void GMmapArea::commit(size_t bytes) noexcept
+{
+    bytes = std::min(pointer::alignSize(bytes, pageSize()), size());
+    if (bytes <= mCommitted) {
+        return;
+    }
+    populate(pointer::add(mBegin, mCommitted), bytes - mCommitted);
+    mCommitted = bytes;
+}
@@ -71,8 +71,35 @@ GByteArray::GByteArray(const std::vector<uint8_t> &data)
 {
 }
 
+GByteArray::GByteArray(std::vector<uint8_t> &&data)
+{
+    if (data.empty()) {
+        reset(1);
+        return;
+    }
+    auto *vector = new std::vector<uint8_t>(std::move(data));
+    mBufferRef = std::make_shared<BufferRef>(vector->data(), static_cast<int64_t>(vector->size()),
+                                             [vector](uint8_t *, int64_t) { delete vector; }, false);
+    mWritePos = mBufferRef->size;
+}
+
+GByteArray::GByteArray(uint8_t *data, int64_t size, ReleaseFunc release)
+{
+    if (!data || size <= 0) {
+        if (data && release) {
+            release(data, size);
+        }
+        reset(1);
+        return;
+    }
+    mBufferRef = std::make_shared<BufferRef>(data, size, std::move(release), false);
+    mWritePos = size;
+}
+
 GByteArray::GByteArray(GByteArray &&other) noexcept
 {
+    std::swap(mOffset, other.mOffset);
+    std::swap(mSliceSize, other.mSliceSize);
     std::swap(mWritePos, other.mWritePos);
     std::swap(mReadPos, other.mReadPos);
     std::swap(mByteOrder, other.mByteOrder);
@@ -81,6 +108,8 @@ GByteArray::GByteArray(GByteArray &&other) noexcept
 
 GByteArray::GByteArray(const GByteArray &other)
 {
+    mOffset = other.mOffset;
+    mSliceSize = other.mSliceSize;
     mWritePos = other.mWritePos;
     mReadPos = other.mReadPos;
     mByteOrder = other.mByteOrder;
@@ -95,6 +124,8 @@ GByteArray::~GByteArray()
 GByteArray &GByteArray::operator=(const GByteArray &b)
 {
     if (this != &b) {
+        mOffset = b.mOffset;
+        mSliceSize = b.mSliceSize;
         mWritePos = b.mWritePos;
         mReadPos = b.mReadPos;
         mByteOrder = b.mByteOrder;
@@ -106,6 +137,8 @@ GByteArray &GByteArray::operator=(const GByteArray &b)
 GByteArray &GByteArray::operator=(GByteArray &&b) noexcept
 {
     if (this != &b) {
+        std::swap(mOffset, b.mOffset);
+        std::swap(mSliceSize, b.mSliceSize);
         std::swap(mWritePos, b.mWritePos);
         std::swap(mReadPos, b.mReadPos);
         std::swap(mByteOrder, b.mByteOrder);
@@ -129,7 +162,13 @@ void GByteArray::reset(int64_t size)
 
 int64_t GByteArray::capacity() const
 {
-    return mBufferRef->size;
+    // A slice stays within its range, the rest of the shared buffer belongs to others
+    return mSliceSize >= 0 ? mSliceSize : mBufferRef->size - mOffset;
+}
+
+void GByteArray::reserve(int64_t capacity)
+{
+    resize(capacity);
 }
 
 int64_t GByteArray::size() const
@@ -144,7 +183,7 @@ bool GByteArray::isEmpty() const
 
 const uint8_t *GByteArray::data() const
 {
-    return mBufferRef->buffer;
+    return mBufferRef->buffer + mOffset;
 }
 
 void GByteArray::clear()
@@ -154,111 +193,83 @@ void GByteArray::clear()
 
 void GByteArray::write(const void *data, int64_t size)
 {
-    if (size <= 0) {
-        return;
-    }
-    copyOnWrite();
-
-    const int64_t outSize = mWritePos + size;
-    if (outSize > mBufferRef->size) {
-        auto newSize = static_cast<int64_t>(static_cast<float>(mBufferRef->size) * 1.5f);
-        if (newSize < outSize) {
-            newSize = static_cast<int64_t>(static_cast<float>(outSize) * 1.5f);
-        }
-        resize(newSize);
-    }
-    uint8_t *p = mBufferRef->buffer + mWritePos;
-    memcpy(p, data, size);
-    byteOrder(p, size);
-
-    mWritePos += size;
+    GByteWriter(*this, mWritePos).write(data, size);
 }
 
 void GByteArray::write(const std::string &in)
 {
-    write(static_cast<int64_t>(in.size()));
-    write(in.data(), in.size());
+    GByteWriter(*this, mWritePos).write(in);
 }
 
 void GByteArray::write(const GString &in)
 {
-    write(static_cast<int64_t>(in.count()));
-    write(in.data(), in.count());
+    GByteWriter(*this, mWritePos).write(in);
 }
 
 void GByteArray::write(const GByteArray &in)
 {
-    write(in.size());
-    write(in.data(), in.size());
+    GByteWriter(*this, mWritePos).write(in);
 }
 
 void GByteArray::write(const std::vector<uint8_t> &in)
 {
-    write(static_cast<int64_t>(in.size()));
-    write(in.data(), in.size());
+    GByteWriter(*this, mWritePos).write(in);
 }
 
 void GByteArray::write(const GAny &any)
 {
-    GByteArray pack;
-    writeGAnyToByteArray(pack, any);
-    write(pack);
+    GByteWriter(*this, mWritePos).write(any);
 }
 
 int64_t GByteArray::read(void *data, int64_t size) const
 {
-    if (mReadPos + size > mWritePos) {
-        size = mWritePos - mReadPos;
-    }
-    if (size <= 0) {
-        return 0;
-    }
-
-    memcpy(data, mBufferRef->buffer + mReadPos, size);
-    byteOrder(static_cast<uint8_t *>(data), size);
-
-    mReadPos += size;
-
-    return size;
+    GByteReader reader(*this, mReadPos);
+    const int64_t readSize = reader.read(data, size);
+    mReadPos = reader.pos();
+    return readSize;
 }
 
 void GByteArray::read(std::string &out) const
 {
-    int64_t size;
-    read(size);
-    out.resize(size);
-    read(out.data(), size);
+    GByteReader reader(*this, mReadPos);
+    reader.read(out);
+    mReadPos = reader.pos();
 }
 
 void GByteArray::read(GString &out) const
 {
-    std::string temp;
-    read(temp);
-    out = temp;
+    GByteReader reader(*this, mReadPos);
+    reader.read(out);
+    mReadPos = reader.pos();
 }
 
 void GByteArray::read(GByteArray &out) const
 {
-    int64_t size;
-    this->read(size);
-    out.reset(size);
-    this->read(out.ptr(), size);
-    out.seekWritePos(SEEK_SET, size);
+    GByteReader reader(*this, mReadPos);
+    reader.read(out);
+    mReadPos = reader.pos();
+}
+
+GByteArray GByteArray::readSlice(int64_t size) const
+{
+    GByteReader reader(*this, mReadPos);
+    GByteArray out = reader.readSlice(size);
+    mReadPos = reader.pos();
+    return out;
 }
 
 void GByteArray::read(std::vector<uint8_t> &out) const
 {
-    int64_t size;
-    this->read(size);
-    out.resize(size);
-    this->read(out.data(), size);
+    GByteReader reader(*this, mReadPos);
+    reader.read(out);
+    mReadPos = reader.pos();
 }
 
 void GByteArray::read(GAny &any) const
 {
-    GByteArray pack;
-    read(pack);
-    any = readGAnyFromByteArray(pack);
+    GByteReader reader(*this, mReadPos);
+    reader.read(any);
+    mReadPos = reader.pos();
 }
 
 void GByteArray::seekWritePos(int mode, int64_t size)
@@ -273,22 +284,38 @@ void GByteArray::seekWritePos(int mode, int64_t size)
             pos = mWritePos + size;
             break;
         case SEEK_END:
-            pos = mBufferRef->size + size;
+            pos = capacity() + size;
             break;
     }
 
-    GX_ASSERT_S(pos >= 0 && pos <= mBufferRef->size,
-                "GByteArray::seekWritePos error (pos: %d out range(0-%d))", pos, mBufferRef->size);
+    GX_ASSERT_S(pos >= 0 && pos <= capacity(),
+                "GByteArray::seekWritePos error (pos: %d out range(0-%d))", pos, capacity());
 
     if (pos < 0) {
         pos = 0;
     }
-    if (pos > mBufferRef->size) {
-        pos = mBufferRef->size;
+    if (pos > capacity()) {
+        pos = capacity();
+    }
+    if (mOffset + pos > mBufferRef->initialized) {
+        // Never written, zeroed rather than exposing what the allocation held. Detaching may shrink a slice
+        uint8_t *p = ptr();
+        pos = std::min(pos, capacity());
+        const int64_t initialized = mBufferRef->initialized - mOffset;
+        if (pos > initialized) {
+            memset(p + initialized, 0, pos - initialized);
+            mBufferRef->initialized = mOffset + pos;
+        }
     }
     mWritePos = pos;
 }
 
+void GByteArray::setWritten(int64_t size)
+{
+    mBufferRef->initialized = std::max(mBufferRef->initialized, mOffset + size);
+    mWritePos = size;
+}
+
 void GByteArray::seekReadPos(int mode, int64_t size) const
 {
     int64_t pos;
@@ -301,18 +328,18 @@ void GByteArray::seekReadPos(int mode, int64_t size) const
             pos = mReadPos + size;
             break;
         case SEEK_END:
-            pos = mBufferRef->size + size;
+            pos = capacity() + size;
             break;
     }
 
-    GX_ASSERT_S(pos >= 0 && pos <= mBufferRef->size,
-                "GByteArray::seekReadPos error (pos: %d out range(0-%d))", pos, mBufferRef->size);
+    GX_ASSERT_S(pos >= 0 && pos <= capacity(),
+                "GByteArray::seekReadPos error (pos: %d out range(0-%d))", pos, capacity());
 
     if (pos < 0) {
         pos = 0;
     }
-    if (pos > mBufferRef->size) {
-        pos = mBufferRef->size;
+    if (pos > capacity()) {
+        pos = capacity();
     }
     mReadPos = pos;
 }
@@ -332,6 +359,20 @@ bool GByteArray::canReadMore() const
     return mReadPos < mWritePos;
 }
 
+GByteArray GByteArray::slice(int64_t pos, int64_t length) const
+{
+    pos = std::clamp(pos, static_cast<int64_t>(0), mWritePos);
+    if (length < 0 || length > mWritePos - pos) {
+        length = mWritePos - pos;
+    }
+    GByteArray out(*this);
+    out.mOffset = mOffset + pos;
+    out.mSliceSize = length;
+    out.mWritePos = length;
+    out.mReadPos = 0;
+    return out;
+}
+
 bool GByteArray::compare(const GByteArray &other) const
 {
     return size() == other.size() && memcmp(data(), other.data(), size()) == 0;
@@ -345,7 +386,7 @@ std::string GByteArray::toHexString(bool uppercase) const
         ss << std::uppercase;
     }
     for (int64_t i = 0; i < size(); i++) {
-        ss << std::setw(2) << static_cast<int>(mBufferRef->buffer[i]);
+        ss << std::setw(2) << static_cast<int>(data()[i]);
     }
     return ss.str();
 }
@@ -360,6 +401,17 @@ std::string GByteArray::toString() const
     return ss.str();
 }
 
+GByteArray GByteArray::borrow(const uint8_t *data, int64_t size)
+{
+    GByteArray ba;
+    if (!data || size <= 0) {
+        return ba;
+    }
+    ba.mBufferRef = std::make_shared<BufferRef>(const_cast<uint8_t *>(data), size, nullptr, true);
+    ba.mWritePos = size;
+    return ba;
+}
+
 GByteArray GByteArray::fromHexString(const std::string &hexString)
 {
     // Convert the string to lowercase first
@@ -589,8 +641,22 @@ GByteArray GByteArray::sha256Sum(const GByteArray &data)
 void GByteArray::resize(int64_t size)
 {
     if (mBufferRef) {
-        if (size > mBufferRef->size) {
-            copyOnWrite();
+        const bool shared = mBufferRef.use_count() > 1 || mBufferRef->borrowed;
+        if (size <= capacity()) {
+            return;
+        }
+        const bool slice = mSliceSize >= 0;
+        if (shared || slice) {
+            // Copy on write straight into the larger buffer, a slice only takes its written range along,
+            // the bytes never written or zeroed are not worth copying
+            const int64_t keep = slice ? mWritePos : std::min(capacity(), mBufferRef->initialized - mOffset);
+            const auto newBufferRef = std::make_shared<BufferRef>(size);
+            memcpy(newBufferRef->buffer, data(), keep);
+            newBufferRef->initialized = keep;
+            mBufferRef = newBufferRef;
+            mOffset = 0;
+            mSliceSize = -1;
+        } else {
             mBufferRef->resize(size);
         }
     } else {
@@ -601,7 +667,7 @@ void GByteArray::resize(int64_t size)
 uint8_t *GByteArray::ptr()
 {
     copyOnWrite();
-    return mBufferRef->buffer;
+    return mBufferRef->buffer + mOffset;
 }
 
 void GByteArray::align(int64_t *pos, int64_t alignment)
@@ -611,7 +677,7 @@ void GByteArray::align(int64_t *pos, int64_t alignment)
     *pos = xpos;
 }
 
-void GByteArray::byteOrder(uint8_t *data, int64_t len) const
+bool GByteArray::needsByteOrderConversion() const
 {
     static ByteOrder systemOrder =
 #if GX_CPU_ENDIAN_LITTLE
@@ -620,33 +686,68 @@ void GByteArray::byteOrder(uint8_t *data, int64_t len) const
             BigEndian;
 #endif
 
-    if (mByteOrder != systemOrder) {
+    return mByteOrder != systemOrder;
+}
+
+void GByteArray::byteOrder(uint8_t *data, int64_t len) const
+{
+    if (needsByteOrderConversion()) {
         std::reverse(data, data + len);
     }
 }
 
 void GByteArray::copyOnWrite()
 {
-    if (mBufferRef.use_count() <= 1) {
+    if (mBufferRef.use_count() <= 1 && !mBufferRef->borrowed) {
+        return;
+    }
+
+    if (mSliceSize >= 0) {
+        // A slice is promoted with its own range only, of which only the written bytes are copied
+        const auto newBufferRef = std::make_shared<BufferRef>(std::max(mSliceSize, static_cast<int64_t>(1)));
+        memcpy(newBufferRef->buffer, data(), mWritePos);
+        newBufferRef->initialized = mWritePos;
+        mBufferRef = newBufferRef;
+        mOffset = 0;
+        mSliceSize = -1;
         return;
     }
 
+    // Only the initialized bytes, a large reserve() followed by a small write stays a small copy
     const auto newBufferRef = std::make_shared<BufferRef>(mBufferRef->size);
-    memcpy(newBufferRef->buffer, mBufferRef->buffer, mBufferRef->size);
+    memcpy(newBufferRef->buffer, mBufferRef->buffer, mBufferRef->initialized);
+    newBufferRef->initialized = mBufferRef->initialized;
 
     mBufferRef = newBufferRef;
 }
 
 GByteArray::BufferRef::BufferRef(int64_t size)
 {
+    // Not zero filled, seekWritePos() zeroes what it exposes past the initialized bytes
     this->size = size;
     buffer = static_cast<uint8_t *>(malloc(size));
-    memset(buffer, 0, size);
+    GX_ASSERT_S(buffer, "GByteArray: allocation of %lld bytes failed", static_cast<long long>(size));
+}
+
+GByteArray::BufferRef::BufferRef(uint8_t *buffer, int64_t size, ReleaseFunc release, bool borrowed)
+    : buffer(buffer),
+      size(size),
+      initialized(size),
+      release(std::move(release)),
+      borrowed(borrowed)
+{
 }
 
 GByteArray::BufferRef::~BufferRef()
 {
-    free(buffer);
+    if (borrowed) {
+        return;
+    }
+    if (release) {
+        release(buffer, size);
+    } else {
+        free(buffer);
+    }
 }
 
 void GByteArray::BufferRef::resize(int64_t newSize)
@@ -654,14 +755,251 @@ void GByteArray::BufferRef::resize(int64_t newSize)
     if (newSize <= this->size) {
         return;
     }
-    auto *newBuffer = static_cast<uint8_t *>(malloc(newSize));
-    memset(newBuffer, 0, newSize);
-    memcpy(newBuffer, this->buffer, std::min(this->size, newSize));
-    free(this->buffer);
+    if (release) {
+        // Adopted memory cannot be reallocated, move to the heap and hand it back now
+        auto *newBuffer = static_cast<uint8_t *>(malloc(newSize));
+        GX_ASSERT_S(newBuffer, "GByteArray: allocation of %lld bytes failed", static_cast<long long>(newSize));
+        if (!newBuffer) {
+            return;
+        }
+        memcpy(newBuffer, this->buffer, this->size);
+        release(this->buffer, this->size);
+        release = nullptr;
+        this->buffer = newBuffer;
+        this->size = newSize;
+        return;
+    }
+    // Large blocks are mmap'd by the allocator and moved with mremap, without copying
+    auto *newBuffer = static_cast<uint8_t *>(realloc(this->buffer, newSize));
+    GX_ASSERT_S(newBuffer, "GByteArray: reallocation to %lld bytes failed", static_cast<long long>(newSize));
+    if (!newBuffer) {
+        return;
+    }
     this->buffer = newBuffer;
     this->size = newSize;
 }
 
+/// ================ GByteReader ================
+
+GByteReader::GByteReader(const GByteArray &buffer, int64_t pos)
+    : mBuffer(&buffer),
+      mPos(std::clamp(pos, static_cast<int64_t>(0), buffer.size()))
+{
+}
+
+const GByteArray &GByteReader::buffer() const
+{
+    return *mBuffer;
+}
+
+int64_t GByteReader::read(void *data, int64_t size)
+{
+    const int64_t end = mBuffer->size();
+    if (mPos + size > end) {
+        size = end - mPos;
+    }
+    if (size <= 0) {
+        return 0;
+    }
+
+    memcpy(data, mBuffer->data() + mPos, size);
+    mBuffer->byteOrder(static_cast<uint8_t *>(data), size);
+
+    mPos += size;
+
+    return size;
+}
+
+void GByteReader::read(std::string &out)
+{
+    int64_t size;
+    read(size);
+    out.resize(size);
+    read(out.data(), size);
+}
+
+void GByteReader::read(GString &out)
+{
+    std::string temp;
+    read(temp);
+    out = temp;
+}
+
+void GByteReader::read(GByteArray &out)
+{
+    int64_t size;
+    read(size);
+    if (!mBuffer->needsByteOrderConversion()) {
+        const GByteArray::ByteOrder outByteOrder = out.mByteOrder;
+        out = readSlice(size);
+        out.mByteOrder = outByteOrder;
+        return;
+    }
+    // The payload was written reversed as a whole, it cannot be shared
+    out.reset(size);
+    out.setWritten(read(out.ptr(), size));
+}
+
+GByteArray GByteReader::readSlice(int64_t size)
+{
+    GByteArray out = mBuffer->slice(mPos, std::max(static_cast<int64_t>(0), std::min(size, remaining())));
+    mPos += out.size();
+    return out;
+}
+
+void GByteReader::read(std::vector<uint8_t> &out)
+{
+    int64_t size;
+    read(size);
+    out.resize(size);
+    read(out.data(), size);
+}
+
+void GByteReader::read(GAny &any)
+{
+    GByteArray pack;
+    read(pack);
+    any = readGAnyFromByteArray(pack);
+}
+
+void GByteReader::seek(int mode, int64_t size)
+{
+    const int64_t end = mBuffer->size();
+    int64_t pos;
+    switch (mode) {
+        case SEEK_SET:
+            pos = size;
+            break;
+        default:
+        case SEEK_CUR:
+            pos = mPos + size;
+            break;
+        case SEEK_END:
+            pos = end + size;
+            break;
+    }
+
+    GX_ASSERT_S(pos >= 0 && pos <= end,
+                "GByteReader::seek error (pos: %d out range(0-%d))", pos, end);
+
+    mPos = std::clamp(pos, static_cast<int64_t>(0), end);
+}
+
+int64_t GByteReader::pos() const
+{
+    return mPos;
+}
+
+int64_t GByteReader::remaining() const
+{
+    return mBuffer->size() - mPos;
+}
+
+bool GByteReader::canReadMore() const
+{
+    return mPos < mBuffer->size();
+}
+
+/// ================ GByteWriter ================
+
+GByteWriter::GByteWriter(GByteArray &buffer)
+    : GByteWriter(buffer, buffer.size())
+{
+}
+
+GByteWriter::GByteWriter(GByteArray &buffer, int64_t pos)
+    : mBuffer(&buffer),
+      mPos(std::clamp(pos, static_cast<int64_t>(0), buffer.size()))
+{
+}
+
+GByteArray &GByteWriter::buffer() const
+{
+    return *mBuffer;
+}
+
+void GByteWriter::write(const void *data, int64_t size)
+{
+    if (size <= 0) {
+        return;
+    }
+    GByteArray &ba = *mBuffer;
+    const int64_t outSize = mPos + size;
+    if (outSize > ba.capacity()) {
+        // Grow by half of the capacity at least, in place when the allocator can.
+        // resize() copies a shared buffer or a slice into the new one, a copyOnWrite() first would copy twice
+        ba.resize(std::max(outSize, ba.capacity() + ba.capacity() / 2));
+    } else {
+        ba.copyOnWrite();
+    }
+    uint8_t *p = ba.mBufferRef->buffer + ba.mOffset + mPos;
+    memcpy(p, data, size);
+    ba.byteOrder(p, size);
+
+    mPos = outSize;
+    ba.mWritePos = std::max(ba.mWritePos, mPos);
+    ba.mBufferRef->initialized = std::max(ba.mBufferRef->initialized, ba.mOffset + mPos);
+}
+
+void GByteWriter::write(const std::string &in)
+{
+    write(static_cast<int64_t>(in.size()));
+    write(in.data(), in.size());
+}
+
+void GByteWriter::write(const GString &in)
+{
+    write(static_cast<int64_t>(in.count()));
+    write(in.data(), in.count());
+}
+
+void GByteWriter::write(const GByteArray &in)
+{
+    write(in.size());
+    write(in.data(), in.size());
+}
+
+void GByteWriter::write(const std::vector<uint8_t> &in)
+{
+    write(static_cast<int64_t>(in.size()));
+    write(in.data(), in.size());
+}
+
+void GByteWriter::write(const GAny &any)
+{
+    GByteArray pack;
+    writeGAnyToByteArray(pack, any);
+    write(pack);
+}
+
+void GByteWriter::seek(int mode, int64_t size)
+{
+    const int64_t end = mBuffer->size();
+    int64_t pos;
+    switch (mode) {
+        case SEEK_SET:
+            pos = size;
+            break;
+        default:
+        case SEEK_CUR:
+            pos = mPos + size;
+            break;
+        case SEEK_END:
+            pos = end + size;
+            break;
+    }
+
+    GX_ASSERT_S(pos >= 0 && pos <= end,
+                "GByteWriter::seek error (pos: %d out range(0-%d))", pos, end);
+
+    mPos = std::clamp(pos, static_cast<int64_t>(0), end);
+}
+
+int64_t GByteWriter::pos() const
+{
+    return mPos;
+}
+
 /// ================ GAny ================
 
 void writeGAnyObjectToByteArray(GByteArray &ba, const GAny &obj)
@@ -0,0 +1,228 @@
+//
+// Created by Gxin on 2024/4/3.
+//
+
+#include "gx/gepoch.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+
+namespace
+{
+
+struct Domains
+{
+    GMutex lock;
+    std::unordered_map<uint64_t, GEpochDomain *> live;
+    uint64_t nextId = 1;
+};
+
+Domains &domains()
+{
+    // Never destroyed, threads may exit after the other statics are gone
+    static auto *domains = new Domains();
+    return *domains;
+}
+
+uint64_t registerDomain(GEpochDomain *domain)
+{
+    Domains &d = domains();
+    GLockerGuard locker(d.lock);
+    const uint64_t id = d.nextId++;
+    d.live[id] = domain;
+    return id;
+}
+
+}
+
+/**
+ * Records of the calling thread, one per domain it used, given back to the domains still alive when the thread exits.
+ * Domains are identified by an id which is never reused, a new domain at the address of a destroyed one is not confused with it.
+ */
+struct GEpochThreadCache
+{
+    struct Entry
+    {
+        uint64_t domainId;
+        GEpochDomain::Record *record;
+    };
+
+    ~GEpochThreadCache()
+    {
+        Domains &d = domains();
+        GLockerGuard locker(d.lock);
+        for (const Entry &e: entries) {
+            const auto it = d.live.find(e.domainId);
+            if (it != d.live.end()) {
+                it->second->releaseRecord(e.record);
+            }
+        }
+    }
+
+    std::vector<Entry> entries;
+};
+
+static thread_local GEpochThreadCache sThreadCache;
+
+
+GEpochDomain::GEpochDomain()
+        : mId(registerDomain(this))
+{
+}
+
+GEpochDomain::~GEpochDomain()
+{
+    {
+        Domains &d = domains();
+        GLockerGuard locker(d.lock);
+        d.live.erase(mId);
+    }
+    Record *record = mRecords.load(std::memory_order_acquire);
+    while (record) {
+        for (const Retired &r: record->retired) {
+            r.deleter(r.p);
+        }
+        Record *next = record->next;
+        delete record;
+        record = next;
+    }
+    for (const Retired &r: mOrphans) {
+        r.deleter(r.p);
+    }
+}
+
+GEpochDomain &GEpochDomain::global()
+{
+    static auto *domain = new GEpochDomain();
+    return *domain;
+}
+
+GEpochDomain::Guard GEpochDomain::pin()
+{
+    Record *record = localRecord();
+    if (record->nesting++ == 0) {
+        const uint64_t epoch = mEpoch.load(std::memory_order_relaxed);
+        // Full barrier, the reclaimers must see the pin before this thread loads any shared pointer
+        record->state.exchange(epoch << 1 | 1, std::memory_order_seq_cst);
+    }
+    return {this, record};
+}
+
+void GEpochDomain::unpin(Record *record) noexcept
+{
+    if (--record->nesting == 0) {
+        record->state.store(0, std::memory_order_release);
+    }
+}
+
+void GEpochDomain::retire(void *p, Deleter deleter)
+{
+    Record *record = localRecord();
+    // The node was unlinked before, it must be tagged with an epoch read after that
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    record->retired.push_back({p, deleter, mEpoch.load(std::memory_order_seq_cst)});
+    if (record->retired.size() % RETIRE_THRESHOLD == 0) {
+        tryAdvance();
+        reclaim(record->retired);
+    }
+}
+
+size_t GEpochDomain::flush()
+{
+    // Two steps free the nodes retired in the current epoch, if no thread stays pinned meanwhile
+    for (int32_t i = 0; i < 2 && tryAdvance(); i++) {
+    }
+    size_t pending = reclaim(localRecord()->retired);
+
+    std::vector<Retired> orphans;
+    {
+        GLockerGuard locker(mOrphanLock);
+        orphans.swap(mOrphans);
+    }
+    pending += reclaim(orphans);
+    if (!orphans.empty()) {
+        GLockerGuard locker(mOrphanLock);
+        mOrphans.insert(mOrphans.end(), orphans.begin(), orphans.end());
+    }
+    return pending;
+}
+
+void GEpochDomain::synchronize()
+{
+    while (flush() != 0) {
+        std::this_thread::yield();
+    }
+}
+
+GEpochDomain::Record *GEpochDomain::localRecord()
+{
+    for (const auto &e: sThreadCache.entries) {
+        if (e.domainId == mId) {
+            return e.record;
+        }
+    }
+    Record *record = acquireRecord();
+    sThreadCache.entries.push_back({mId, record});
+    return record;
+}
+
+GEpochDomain::Record *GEpochDomain::acquireRecord()
+{
+    for (Record *r = mRecords.load(std::memory_order_acquire); r; r = r->next) {
+        bool expected = false;
+        if (!r->inUse.load(std::memory_order_relaxed)
+            && r->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            return r;
+        }
+    }
+    auto *record = new Record();
+    record->inUse.store(true, std::memory_order_relaxed);
+    Record *head = mRecords.load(std::memory_order_relaxed);
+    do {
+        record->next = head;
+    } while (!mRecords.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+    return record;
+}
+
+void GEpochDomain::releaseRecord(Record *record)
+{
+    if (!record->retired.empty()) {
+        GLockerGuard locker(mOrphanLock);
+        mOrphans.insert(mOrphans.end(), record->retired.begin(), record->retired.end());
+    }
+    record->retired.clear();
+    record->nesting = 0;
+    record->state.store(0, std::memory_order_relaxed);
+    record->inUse.store(false, std::memory_order_release);
+}
+
+bool GEpochDomain::tryAdvance() noexcept
+{
+    uint64_t epoch = mEpoch.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (Record *r = mRecords.load(std::memory_order_acquire); r; r = r->next) {
+        const uint64_t state = r->state.load(std::memory_order_seq_cst);
+        if ((state & 1) && (state >> 1) != epoch) {
+            return false;
+        }
+    }
+    // Fails only when another thread advanced it already
+    mEpoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_acq_rel, std::memory_order_relaxed);
+    return true;
+}
+
+size_t GEpochDomain::reclaim(std::vector<Retired> &retired)
+{
+    const uint64_t epoch = mEpoch.load(std::memory_order_acquire);
+    const auto it = std::stable_partition(retired.begin(), retired.end(), [epoch](const Retired &r) {
+        return r.epoch + 2 > epoch;
+    });
+    // Deleters may retire more nodes into the same list, run them on a copy
+    const std::vector<Retired> freeable(it, retired.end());
+    retired.erase(it, retired.end());
+    for (const Retired &r: freeable) {
+        r.deleter(r.p);
+    }
+    return retired.size();
+}
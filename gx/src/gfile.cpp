@@ -315,7 +315,7 @@ GByteArray GFile::read(int64_t maxSize)
     maxSize = maxSize > 0 ? maxSize : fileSize();
     GByteArray buffer(maxSize);
     maxSize = read(reinterpret_cast<char *>(buffer.ptr()), maxSize);
-    buffer.seekWritePos(SEEK_SET, static_cast<int32_t>(maxSize));
+    buffer.setWritten(std::max(maxSize, static_cast<int64_t>(0)));
     return buffer;
 }
 
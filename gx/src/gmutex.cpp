@@ -0,0 +1,222 @@
+//
+// Created by Gxin on 2024/4/2.
+//
+
+#include "gx/gmutex.h"
+
+#include "gx/debug.h"
+
+#include <algorithm>
+#include <map>
+
+#if GX_PLATFORM_LINUX || GX_PLATFORM_ANDROID
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#endif
+
+
+namespace
+{
+
+struct Registry
+{
+    std::mutex lock;    // Not a GMutex, that one may be profiled itself
+    std::vector<GLockTracker *> trackers;
+    std::map<std::string, GLockStats> retired;
+};
+
+Registry &registry()
+{
+    // Never destroyed, static locks may unregister after the other statics are gone
+    static auto *registry = new Registry();
+    return *registry;
+}
+
+void merge(GLockStats &to, const GLockStats &from)
+{
+    to.lockCount += from.lockCount;
+    to.acquisitions += from.acquisitions;
+    to.contendedAcquisitions += from.contendedAcquisitions;
+    to.totalWaitNs += from.totalWaitNs;
+    to.maxWaitNs = std::max(to.maxWaitNs, from.maxWaitNs);
+    to.totalHoldNs += from.totalHoldNs;
+    to.maxHoldNs = std::max(to.maxHoldNs, from.maxHoldNs);
+}
+
+constexpr int32_t SPIN_LIMIT = 40;
+constexpr uint32_t MAX_BACKOFF = 64;
+
+bool isMultiCore() noexcept
+{
+    static const bool multiCore = std::thread::hardware_concurrency() > 1;
+    return multiCore;
+}
+
+void futexWait(std::atomic<uint32_t> &state, uint32_t value) noexcept
+{
+#if GX_PLATFORM_LINUX || GX_PLATFORM_ANDROID
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&state), FUTEX_WAIT_PRIVATE, value, nullptr, nullptr, 0);
+#else
+    state.wait(value, std::memory_order_relaxed);
+#endif
+}
+
+void futexWakeOne(std::atomic<uint32_t> &state) noexcept
+{
+#if GX_PLATFORM_LINUX || GX_PLATFORM_ANDROID
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&state), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#else
+    state.notify_one();
+#endif
+}
+
+}
+
+void GRawAdaptiveLock::lockSlow() noexcept
+{
+    if (isMultiCore()) {
+        uint32_t backoff = 1;
+        for (int32_t spin = 0; spin < SPIN_LIMIT; spin++) {
+            uint32_t state = mState.load(std::memory_order_relaxed);
+            if (state == UNLOCKED
+                && mState.compare_exchange_weak(state, LOCKED, std::memory_order_acquire, std::memory_order_relaxed)) {
+                return;
+            }
+            if (state == CONTENDED) {
+                // Others are parked already, the lock is not about to be free
+                break;
+            }
+            for (uint32_t i = 0; i < backoff; i++) {
+                gx::cpuRelax();
+            }
+            backoff = std::min(backoff * 2, MAX_BACKOFF);
+        }
+    }
+    // Whoever takes the lock from here leaves it CONTENDED, since other threads may still be parked
+    while (mState.exchange(CONTENDED, std::memory_order_acquire) != UNLOCKED) {
+        futexWait(mState, CONTENDED);
+    }
+}
+
+void GRawAdaptiveLock::wake() noexcept
+{
+    futexWakeOne(mState);
+}
+
+GLockTracker::GLockTracker(const char *name, const std::source_location &location) noexcept
+{
+    if (name) {
+        mName = name;
+    } else {
+        const std::string_view file = location.file_name();
+        const size_t slash = file.find_last_of("/\\");
+        mName = std::string(slash == std::string_view::npos ? file : file.substr(slash + 1));
+        mName += ":" + std::to_string(location.line());
+    }
+    GLockRegistry::add(this);
+}
+
+GLockTracker::~GLockTracker() noexcept
+{
+    GLockRegistry::remove(this);
+}
+
+GLockStats GLockTracker::stats() const
+{
+    GLockStats stats;
+    stats.name = mName;
+    stats.lockCount = 1;
+    stats.acquisitions = mAcquisitions.load(std::memory_order_relaxed);
+    stats.contendedAcquisitions = mContendedAcquisitions.load(std::memory_order_relaxed);
+    stats.totalWaitNs = mTotalWaitNs.load(std::memory_order_relaxed);
+    stats.maxWaitNs = mMaxWaitNs.load(std::memory_order_relaxed);
+    stats.totalHoldNs = mTotalHoldNs.load(std::memory_order_relaxed);
+    stats.maxHoldNs = mMaxHoldNs.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void GLockTracker::resetCounters() noexcept
+{
+    mAcquisitions.store(0, std::memory_order_relaxed);
+    mContendedAcquisitions.store(0, std::memory_order_relaxed);
+    mTotalWaitNs.store(0, std::memory_order_relaxed);
+    mMaxWaitNs.store(0, std::memory_order_relaxed);
+    mTotalHoldNs.store(0, std::memory_order_relaxed);
+    mMaxHoldNs.store(0, std::memory_order_relaxed);
+}
+
+std::vector<GLockStats> GLockRegistry::snapshot()
+{
+    Registry &r = registry();
+    std::map<std::string, GLockStats> merged;
+    {
+        std::lock_guard<std::mutex> locker(r.lock);
+        merged = r.retired;
+        for (const GLockTracker *tracker: r.trackers) {
+            const GLockStats stats = tracker->stats();
+            GLockStats &to = merged[stats.name];
+            to.name = stats.name;
+            merge(to, stats);
+        }
+    }
+    std::vector<GLockStats> result;
+    result.reserve(merged.size());
+    for (auto &it: merged) {
+        result.push_back(std::move(it.second));
+    }
+    std::sort(result.begin(), result.end(), [](const GLockStats &a, const GLockStats &b) {
+        return a.totalWaitNs > b.totalWaitNs;
+    });
+    return result;
+}
+
+void GLockRegistry::dump()
+{
+    const auto locks = snapshot();
+    Log("Profiled locks: {}", locks.size());
+    for (const auto &s: locks) {
+        Log("  {} (x{}): acquisitions = {}, contended = {}, wait total = {} us, max = {} us, hold total = {} us, max = {} us",
+            s.name, s.lockCount, s.acquisitions, s.contendedAcquisitions,
+            s.totalWaitNs / 1000, s.maxWaitNs / 1000, s.totalHoldNs / 1000, s.maxHoldNs / 1000);
+    }
+}
+
+void GLockRegistry::reset()
+{
+    Registry &r = registry();
+    std::lock_guard<std::mutex> locker(r.lock);
+    r.retired.clear();
+    for (GLockTracker *tracker: r.trackers) {
+        tracker->resetCounters();
+    }
+}
+
+void GLockRegistry::add(GLockTracker *tracker)
+{
+    Registry &r = registry();
+    std::lock_guard<std::mutex> locker(r.lock);
+    tracker->mRegistryIndex = r.trackers.size();
+    r.trackers.push_back(tracker);
+}
+
+void GLockRegistry::remove(GLockTracker *tracker)
+{
+    Registry &r = registry();
+    std::lock_guard<std::mutex> locker(r.lock);
+    const size_t index = tracker->mRegistryIndex;
+    if (index >= r.trackers.size() || r.trackers[index] != tracker) {
+        return;
+    }
+    // The order does not matter, the last tracker takes the freed position
+    GLockTracker *last = r.trackers.back();
+    r.trackers[index] = last;
+    last->mRegistryIndex = index;
+    r.trackers.pop_back();
+    const GLockStats stats = tracker->stats();
+    GLockStats &to = r.retired[stats.name];
+    to.name = stats.name;
+    merge(to, stats);
+}
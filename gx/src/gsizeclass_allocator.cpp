@@ -0,0 +1,370 @@
+//
+// Created by Gxin on 2024/3/28.
+//
+
+#include "gx/gsizeclass_allocator.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <vector>
+
+
+namespace
+{
+
+constexpr size_t SPAN_MASK = GSizeClassAllocator::SPAN_SIZE - 1;
+constexpr size_t SPANS_PER_CHUNK = 16;
+constexpr int32_t LINEAR_CLASS_COUNT = 8;   // 16 ~ 128 in steps of 16
+constexpr int32_t STEPS_PER_DOUBLING = 4;   // Then 4 classes per power of two, at most 25% internal waste
+
+struct SpanHeader
+{
+    int32_t sizeClass;
+};
+
+struct Node
+{
+    Node *next;
+};
+
+struct ClassInfo
+{
+    uint32_t size;
+    uint32_t alignment;     // Alignment of every object of the class
+    uint32_t firstOffset;   // Offset of the first object in a span
+    uint32_t objectCount;   // Objects in a span
+    uint32_t batchSize;     // Objects moved between a thread cache and the depot at once
+};
+
+constexpr size_t computeClassSize(int32_t cls)
+{
+    if (cls < LINEAR_CLASS_COUNT) {
+        return static_cast<size_t>(cls + 1) * 16;
+    }
+    const int32_t k = cls - LINEAR_CLASS_COUNT;
+    const size_t base = size_t(128) << (k / STEPS_PER_DOUBLING);
+    return base + static_cast<size_t>(k % STEPS_PER_DOUBLING + 1) * (base / STEPS_PER_DOUBLING);
+}
+
+constexpr std::array<ClassInfo, GSizeClassAllocator::CLASS_COUNT> makeClassTable()
+{
+    std::array<ClassInfo, GSizeClassAllocator::CLASS_COUNT> table{};
+    for (int32_t cls = 0; cls < GSizeClassAllocator::CLASS_COUNT; cls++) {
+        ClassInfo &info = table[cls];
+        const size_t size = computeClassSize(cls);
+        const size_t alignment = std::min(size & (~size + 1), GSizeClassAllocator::MAX_CLASS_ALIGNMENT);
+        const size_t firstOffset = (sizeof(SpanHeader) + alignment - 1) & ~(alignment - 1);
+        info.size = static_cast<uint32_t>(size);
+        info.alignment = static_cast<uint32_t>(alignment);
+        info.firstOffset = static_cast<uint32_t>(firstOffset);
+        info.objectCount = static_cast<uint32_t>((GSizeClassAllocator::SPAN_SIZE - firstOffset) / size);
+        info.batchSize = static_cast<uint32_t>(std::clamp<size_t>(32 * 1024 / size, 2, 64));
+    }
+    return table;
+}
+
+constexpr auto CLASS_TABLE = makeClassTable();
+
+static_assert(computeClassSize(GSizeClassAllocator::CLASS_COUNT - 1) == GSizeClassAllocator::MAX_SMALL_SIZE);
+
+/**
+ * Singly linked chain of free objects
+ */
+struct FreeList
+{
+    Node *head = nullptr;
+    uint32_t count = 0;
+
+    void push(void *p) noexcept
+    {
+        Node *node = static_cast<Node *>(p);
+        node->next = head;
+        head = node;
+        ++count;
+    }
+
+    void *pop() noexcept
+    {
+        Node *node = head;
+        head = node->next;
+        --count;
+        return node;
+    }
+
+    /**
+     * @brief Detach up to n objects from the front
+     */
+    FreeList take(uint32_t n) noexcept
+    {
+        FreeList batch;
+        if (n >= count) {
+            std::swap(batch, *this);
+            return batch;
+        }
+        batch.head = head;
+        Node *last = head;
+        for (uint32_t i = 1; i < n; i++) {
+            last = last->next;
+        }
+        head = last->next;
+        last->next = nullptr;
+        batch.count = n;
+        count -= n;
+        return batch;
+    }
+};
+
+/**
+ * The central depot, keeps the batches (magazines) released by the thread caches
+ * and carves new objects from spans.
+ */
+class SizeClassHeap
+{
+public:
+    FreeList popBatch(int32_t cls)
+    {
+        CentralList &central = mCentral[cls];
+        GLockerGuard locker(central.lock);
+        if (!central.batches.empty()) {
+            const FreeList batch = central.batches.back();
+            central.batches.pop_back();
+            mDepotBytes.fetch_sub(size_t(batch.count) * CLASS_TABLE[cls].size, std::memory_order_relaxed);
+            return batch;
+        }
+        return carve(cls, central);
+    }
+
+    void pushBatch(int32_t cls, const FreeList &batch)
+    {
+        if (!batch.head) {
+            return;
+        }
+        CentralList &central = mCentral[cls];
+        GLockerGuard locker(central.lock);
+        central.batches.push_back(batch);
+        mDepotBytes.fetch_add(size_t(batch.count) * CLASS_TABLE[cls].size, std::memory_order_relaxed);
+    }
+
+    void *allocLarge(size_t size, size_t alignment)
+    {
+        mLargeAllocs.fetch_add(1, std::memory_order_relaxed);
+        return gx::alignedAlloc(std::max<size_t>(size, 1), std::max(alignment, GSizeClassAllocator::SPAN_SIZE));
+    }
+
+    GSizeClassAllocator::Stats stats() const
+    {
+        GSizeClassAllocator::Stats stats;
+        stats.reservedBytes = mReservedBytes.load(std::memory_order_relaxed);
+        stats.depotBytes = mDepotBytes.load(std::memory_order_relaxed);
+        stats.largeAllocs = mLargeAllocs.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    struct alignas(GX_CACHE_LINE_SIZE) CentralList
+    {
+        GMutex lock;
+        std::vector<FreeList> batches;
+        char *carveBegin = nullptr;
+        char *carveEnd = nullptr;
+    };
+
+    FreeList carve(int32_t cls, CentralList &central)
+    {
+        const ClassInfo &info = CLASS_TABLE[cls];
+        if (central.carveBegin == central.carveEnd) {
+            char *span = static_cast<char *>(allocSpan());
+            if (!span) {
+                return {};
+            }
+            reinterpret_cast<SpanHeader *>(span)->sizeClass = cls;
+            central.carveBegin = span + info.firstOffset;
+            central.carveEnd = central.carveBegin + size_t(info.objectCount) * info.size;
+        }
+        const size_t available = (central.carveEnd - central.carveBegin) / info.size;
+        const auto n = static_cast<uint32_t>(std::min<size_t>(available, info.batchSize));
+
+        FreeList batch;
+        // Push in reverse so the objects are handed out in address order
+        for (uint32_t i = n; i > 0; i--) {
+            batch.push(central.carveBegin + size_t(i - 1) * info.size);
+        }
+        central.carveBegin += size_t(n) * info.size;
+        return batch;
+    }
+
+    void *allocSpan()
+    {
+        GLockerGuard locker(mSpanLock);
+        if (mChunkBegin == mChunkEnd) {
+            constexpr size_t chunkSize = GSizeClassAllocator::SPAN_SIZE * SPANS_PER_CHUNK;
+            mChunkBegin = static_cast<char *>(gx::alignedAlloc(chunkSize, GSizeClassAllocator::SPAN_SIZE));
+            if (!mChunkBegin) {
+                mChunkEnd = nullptr;
+                return nullptr;
+            }
+            mChunkEnd = mChunkBegin + chunkSize;
+            mReservedBytes.fetch_add(chunkSize, std::memory_order_relaxed);
+        }
+        void *span = mChunkBegin;
+        mChunkBegin += GSizeClassAllocator::SPAN_SIZE;
+        return span;
+    }
+
+private:
+    CentralList mCentral[GSizeClassAllocator::CLASS_COUNT];
+
+    GMutex mSpanLock;
+    char *mChunkBegin = nullptr;
+    char *mChunkEnd = nullptr;
+
+    std::atomic<size_t> mReservedBytes{0};
+    std::atomic<size_t> mDepotBytes{0};
+    std::atomic<uint64_t> mLargeAllocs{0};
+};
+
+SizeClassHeap &sizeClassHeap()
+{
+    // Never destroyed, objects may still be freed by static destructors and exiting threads
+    static auto *heap = new SizeClassHeap();
+    return *heap;
+}
+
+thread_local bool sThreadCacheDestroyed = false;
+
+struct ThreadCache
+{
+    FreeList lists[GSizeClassAllocator::CLASS_COUNT];
+
+    ~ThreadCache()
+    {
+        flush();
+        sThreadCacheDestroyed = true;
+    }
+
+    void flush() noexcept
+    {
+        SizeClassHeap &heap = sizeClassHeap();
+        for (int32_t cls = 0; cls < GSizeClassAllocator::CLASS_COUNT; cls++) {
+            FreeList &list = lists[cls];
+            while (list.head) {
+                heap.pushBatch(cls, list.take(CLASS_TABLE[cls].batchSize));
+            }
+        }
+    }
+};
+
+ThreadCache *threadCache() noexcept
+{
+    // After the cache of an exiting thread is gone, its remaining frees go straight to the depot
+    if (sThreadCacheDestroyed) {
+        return nullptr;
+    }
+    thread_local ThreadCache cache;
+    return &cache;
+}
+
+}
+
+void *GSizeClassAllocator::alloc(size_t size, size_t alignment, size_t extra)
+{
+    // This allocator does not support 'extra'
+    GX_ASSERT(extra == 0);
+
+    SizeClassHeap &heap = sizeClassHeap();
+    const int32_t cls = sizeClass(size, alignment);
+    if (cls < 0) {
+        return heap.allocLarge(size, alignment);
+    }
+
+    ThreadCache *cache = threadCache();
+    if (!cache) {
+        FreeList batch = heap.popBatch(cls);
+        if (!batch.head) {
+            return nullptr;
+        }
+        void *p = batch.pop();
+        heap.pushBatch(cls, batch);
+        return p;
+    }
+    FreeList &list = cache->lists[cls];
+    if (!list.head) {
+        list = heap.popBatch(cls);
+        if (!list.head) {
+            return nullptr;
+        }
+    }
+    return list.pop();
+}
+
+void GSizeClassAllocator::free(void *p) noexcept
+{
+    if (!p) {
+        return;
+    }
+    // Small objects never start at a span boundary, the span header is there
+    if ((reinterpret_cast<uintptr_t>(p) & SPAN_MASK) == 0) {
+        gx::alignedFree(p);
+        return;
+    }
+    const auto *span = reinterpret_cast<const SpanHeader *>(reinterpret_cast<uintptr_t>(p) & ~SPAN_MASK);
+    const int32_t cls = span->sizeClass;
+    GX_ASSERT(cls >= 0 && cls < CLASS_COUNT);
+
+    ThreadCache *cache = threadCache();
+    if (!cache) {
+        FreeList single;
+        single.push(p);
+        sizeClassHeap().pushBatch(cls, single);
+        return;
+    }
+    FreeList &list = cache->lists[cls];
+    list.push(p);
+    const uint32_t batchSize = CLASS_TABLE[cls].batchSize;
+    if (list.count > batchSize * 2) {
+        sizeClassHeap().pushBatch(cls, list.take(batchSize));
+    }
+}
+
+int32_t GSizeClassAllocator::sizeClass(size_t size, size_t alignment) noexcept
+{
+    alignment = std::max(alignment, MIN_ALIGNMENT);
+    size = std::max(size, alignment);
+    if (size > MAX_SMALL_SIZE || alignment > MAX_CLASS_ALIGNMENT) {
+        return -1;
+    }
+    int32_t cls;
+    if (size <= 128) {
+        cls = static_cast<int32_t>((size + 15) / 16) - 1;
+    } else {
+        const size_t base = std::bit_floor(size - 1);
+        const auto doubling = static_cast<int32_t>(std::countr_zero(base)) - 7;
+        cls = LINEAR_CLASS_COUNT + doubling * STEPS_PER_DOUBLING
+              + static_cast<int32_t>((size - 1 - base) / (base / STEPS_PER_DOUBLING));
+    }
+    // Move up to a class whose objects are aligned enough, a power of two class comes within a few steps
+    while (cls < CLASS_COUNT && CLASS_TABLE[cls].alignment < alignment) {
+        cls++;
+    }
+    return cls < CLASS_COUNT ? cls : -1;
+}
+
+size_t GSizeClassAllocator::classSize(int32_t sizeClass) noexcept
+{
+    GX_ASSERT(sizeClass >= 0 && sizeClass < CLASS_COUNT);
+    return CLASS_TABLE[sizeClass].size;
+}
+
+void GSizeClassAllocator::flushThreadCache() noexcept
+{
+    ThreadCache *cache = threadCache();
+    if (cache) {
+        cache->flush();
+    }
+}
+
+GSizeClassAllocator::Stats GSizeClassAllocator::stats() noexcept
+{
+    return sizeClassHeap().stats();
+}
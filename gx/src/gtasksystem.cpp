@@ -7,6 +7,7 @@
 #include "gx/gtasksystem.h"
 
 #include "gx/gthread.h"
+#include "gx/gtime.h"
 #include "gx/debug.h"
 
 #include <sstream>
@@ -14,7 +15,8 @@
 
 GTaskSystem::GTaskSystem(std::string name, uint32_t threadCount)
     : mName(std::move(name)),
-      mThreadCount(threadCount)
+      mThreadCount(threadCount),
+      mStats(std::make_unique<PriorityStats[]>(TASK_PRIORITY_COUNT))
 {
     if (mThreadCount == 0 || mThreadCount > GThread::hardwareConcurrency()) {
         mThreadCount = GThread::hardwareConcurrency();
@@ -61,7 +63,7 @@ void GTaskSystem::start()
                 }
                 if (taskFuncRef.active->load(std::memory_order_relaxed)) {
                     GX_ASSERT(taskFuncRef.func);
-                    taskFuncRef.func();
+                    runTask(taskFuncRef);
                 }
             }
         }, tNameS.str());
@@ -118,10 +120,55 @@ uint64_t GTaskSystem::waitingTaskCount() const
     return mTaskQueue.size();
 }
 
+void GTaskSystem::setStatsEnabled(bool enabled)
+{
+    mStatsEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool GTaskSystem::isStatsEnabled() const
+{
+    return mStatsEnabled.load(std::memory_order_relaxed);
+}
+
+GTaskSystem::TaskStats GTaskSystem::taskStats() const
+{
+    TaskStats stats;
+    for (size_t i = 0; i < TASK_PRIORITY_COUNT; i++) {
+        stats.waitTime.merge(mStats[i].waitTime.snapshot());
+        stats.execTime.merge(mStats[i].execTime.snapshot());
+    }
+    return stats;
+}
+
+GTaskSystem::TaskStats GTaskSystem::taskStats(TaskPriority priority) const
+{
+    const auto &stats = mStats[static_cast<size_t>(priority)];
+    return {stats.waitTime.snapshot(), stats.execTime.snapshot()};
+}
+
+GTaskSystem::TaskStats GTaskSystem::takeTaskStats()
+{
+    TaskStats stats;
+    for (size_t i = 0; i < TASK_PRIORITY_COUNT; i++) {
+        stats.waitTime.merge(mStats[i].waitTime.snapshotAndReset());
+        stats.execTime.merge(mStats[i].execTime.snapshotAndReset());
+    }
+    return stats;
+}
+
+void GTaskSystem::resetTaskStats()
+{
+    for (size_t i = 0; i < TASK_PRIORITY_COUNT; i++) {
+        mStats[i].waitTime.reset();
+        mStats[i].execTime.reset();
+    }
+}
+
 GTaskSystem::TaskFuncRef GTaskSystem::pushTask(const TaskFunc &task)
 {
+    const int64_t now = mStatsEnabled.load(std::memory_order_relaxed) ? GTime::currentSteadyTime().nanosecond() : 0;
     GLockerGuard locker(mLock);
-    TaskFuncRef taskRef{task, std::make_shared<std::atomic<bool> >(true)};
+    TaskFuncRef taskRef{task, std::make_shared<std::atomic<bool> >(true), now, TaskPriority::Normal};
     mTaskQueue.push_back(taskRef);
     mTaskCond.notify_one();
     return taskRef;
@@ -129,8 +176,9 @@ GTaskSystem::TaskFuncRef GTaskSystem::pushTask(const TaskFunc &task)
 
 GTaskSystem::TaskFuncRef GTaskSystem::pushTaskFront(const TaskFunc &task)
 {
+    const int64_t now = mStatsEnabled.load(std::memory_order_relaxed) ? GTime::currentSteadyTime().nanosecond() : 0;
     GLockerGuard locker(mLock);
-    TaskFuncRef taskRef{task, std::make_shared<std::atomic<bool> >(true)};
+    TaskFuncRef taskRef{task, std::make_shared<std::atomic<bool> >(true), now, TaskPriority::High};
     mTaskQueue.push_front(taskRef);
     mTaskCond.notify_one();
     return taskRef;
@@ -141,3 +189,19 @@ void GTaskSystem::clearTask()
     GLockerGuard locker(mLock);
     mTaskQueue.clear();
 }
+
+void GTaskSystem::runTask(const TaskFuncRef &taskFuncRef)
+{
+    // Tasks queued while statistics were disabled carry no enqueue time
+    if (taskFuncRef.enqueueTime == 0 || !mStatsEnabled.load(std::memory_order_relaxed)) {
+        taskFuncRef.func();
+        return;
+    }
+    const int64_t beginTime = GTime::currentSteadyTime().nanosecond();
+    taskFuncRef.func();
+    const int64_t endTime = GTime::currentSteadyTime().nanosecond();
+
+    auto &stats = mStats[static_cast<size_t>(taskFuncRef.priority)];
+    stats.waitTime.record(static_cast<uint64_t>(std::max<int64_t>(beginTime - taskFuncRef.enqueueTime, 0)));
+    stats.execTime.record(static_cast<uint64_t>(std::max<int64_t>(endTime - beginTime, 0)));
+}
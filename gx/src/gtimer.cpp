@@ -4,6 +4,11 @@
 
 #include "gx/gtimer.h"
 
+#include "gtimer_queue.h"
+#include "gtimer_waiter.h"
+
+#include "gx/gtasksystem.h"
+#include "gx/gjobsystem.h"
 #include "gx/debug.h"
 
 #if GX_PLATFORM_WINDOWS
@@ -43,6 +48,41 @@ inline void timeEndPeriod(int32_t t)
 
 static std::weak_ptr<GTimerScheduler> sGlobalScheduler;
 
+static constexpr int64_t NANOS_PER_MILLI = 1000000;
+static constexpr int64_t NANOS_PER_MICRO = 1000;
+
+// Task whose event runs on this thread, waitRuns() from inside the event must not wait for itself
+static thread_local const GTimerTask *tRunningTask = nullptr;
+
+/**
+ * @brief Marks a run counted in GTimerTask::mInFlight, ends it on scope exit
+ */
+class GTimerRunScope
+{
+public:
+    explicit GTimerRunScope(std::atomic<int32_t> &inFlight, const GTimerTask *task)
+        : mInFlight(inFlight),
+          mOuter(tRunningTask)
+    {
+        tRunningTask = task;
+    }
+
+    ~GTimerRunScope()
+    {
+        tRunningTask = mOuter;
+        mInFlight.fetch_sub(1, std::memory_order_release);
+        mInFlight.notify_all();
+    }
+
+    GTimerRunScope(const GTimerRunScope &) = delete;
+
+    GTimerRunScope &operator=(const GTimerRunScope &) = delete;
+
+private:
+    std::atomic<int32_t> &mInFlight;
+    const GTimerTask *const mOuter;
+};
+
 GTimerTask::GTimerTask(GTimerEvent event, GTimerCondition condition, int64_t delay, int64_t interval)
     : mEvent(std::move(event)),
       mCondition(std::move(condition)),
@@ -50,25 +90,62 @@ GTimerTask::GTimerTask(GTimerEvent event, GTimerCondition condition, int64_t del
       mTime(GTime::currentSteadyTime()),
       mValid(true)
 {
-    mTime.addMilliSecs(delay);
+    mTime.addNanoSecs(delay);
 }
 
 void GTimerTask::cancel()
 {
     if (mValid.exchange(false)) {
-        mEvent = nullptr;
-        mCondition = nullptr;
+        {
+            GLockerGuard locker(mRunLock);
+            mEvent = nullptr;
+            mTickEvent = nullptr;
+            mCondition = nullptr;
+        }
+        const auto scheduler = mScheduler.lock();
+        if (scheduler) {
+            scheduler->removeTask(this);
+        }
+    }
+}
+
+void GTimerTask::waitRuns()
+{
+    const int32_t self = tRunningTask == this ? 1 : 0;
+    for (int32_t n = mInFlight.load(std::memory_order_acquire); n > self; n = mInFlight.load(std::memory_order_acquire)) {
+        mInFlight.wait(n, std::memory_order_acquire);
+    }
+}
+
+GTimerScheduler::GTimerScheduler(std::string name, const Options &options)
+    : mName(std::move(name)),
+      mBackend(options.backend),
+      mExecutor(options.executor),
+      mStatsBeginTime(GTime::currentSteadyTime().nanosecond())
+{
+    switch (mBackend) {
+        case Backend::Wheel:
+            mTaskQueue = std::make_unique<GTimerWheelQueue>(std::max<int64_t>(options.wheelTick, 1),
+                                                            GTime::currentSteadyTime().nanosecond());
+            break;
+        case Backend::Heap:
+        default:
+            mTaskQueue = std::make_unique<GTimerHeapQueue>();
+            break;
     }
+    mWaiter = GTimerWaiter::create(options.waitMode, options.spinTime);
 }
 
-GTimerScheduler::GTimerScheduler(std::string name)
-    : mName(std::move(name))
+std::shared_ptr<GTimerScheduler> GTimerScheduler::create(std::string name, Backend backend)
 {
+    Options options;
+    options.backend = backend;
+    return create(std::move(name), options);
 }
 
-std::shared_ptr<GTimerScheduler> GTimerScheduler::create(std::string name)
+std::shared_ptr<GTimerScheduler> GTimerScheduler::create(std::string name, const Options &options)
 {
-    return std::shared_ptr<GTimerScheduler>(GX_NEW(GTimerScheduler, std::move(name)));
+    return std::shared_ptr<GTimerScheduler>(GX_NEW(GTimerScheduler, std::move(name), options));
 }
 
 void GTimerScheduler::makeGlobal(const std::shared_ptr<GTimerScheduler> &obj)
@@ -89,49 +166,20 @@ bool GTimerScheduler::run()
 {
     mIsRunning.store(true);
 
-    while (true) {
-        GTimerTaskPtr task;
-        //
-        {
-            GLocker<GMutex> locker(mLock);
-            mTaskCond.wait(locker, [this] {
-                return !mIsRunning.load() || !mTaskQueue.empty();
-            });
-            if (!mIsRunning.load()) {
-                break;
-            }
-            task = mTaskQueue.top();
-            GTime now = GTime::currentSteadyTime();
-            if (task->mValid.load() && task->mTime > now) {
-                GTime::TimeType timeDiff = task->mTime.milliSecsTo(now);
-                if (timeDiff > 0) {
-                    task.reset();
-                    gx::timeBeginPeriod(1);
-                    mTaskCond.wait_for(locker, std::chrono::milliseconds(timeDiff));
-                    gx::timeEndPeriod(1);
-                    continue;
-                }
-            }
-            mTaskQueue.pop();
-        }
-        GTimerEvent event;
-        if (task && task->mValid.load() && ((event = task->mEvent))) {
-            auto pushQueue = [&] {
-                task->mTime.update();
-                task->mTime.addMilliSecs(task->mInterval); {
-                    GLocker<GMutex> locker(mLock);
-                    mTaskQueue.push(task);
-                }
-            };
-            if (task->mCondition && !task->mCondition()) {
-                pushQueue();
-            } else {
-                event();
-                if (!task->mOneShot) {
-                    pushQueue();
-                }
-            }
+    GLocker<GMutex> locker(mLock);
+    while (mIsRunning.load()) {
+        GTimerTaskPtr task = mTaskQueue->popExpired(GTime::currentSteadyTime().nanosecond());
+        if (task) {
+            locker.unlock();
+            executeTask(task);
+            task.reset();
+            locker.lock();
+            continue;
         }
+        gx::timeBeginPeriod(1);
+        mWaiter->wait(locker, mTaskQueue->nextDeadline());
+        gx::timeEndPeriod(1);
+        mWakeups.fetch_add(1, std::memory_order_relaxed);
     }
 
     return true;
@@ -140,38 +188,17 @@ bool GTimerScheduler::run()
 int64_t GTimerScheduler::loop(int64_t maxTime)
 {
     const GTime beginTime = GTime::currentSteadyTime();
-    GTimerTaskPtr task;
+    mWakeups.fetch_add(1, std::memory_order_relaxed);
     while (mIsRunning.load()) {
+        GTimerTaskPtr task;
         {
             GLocker<GMutex> locker(mLock);
-            if (mTaskQueue.empty()) {
-                break;
-            }
-            GTime now = GTime::currentSteadyTime();
-            task = mTaskQueue.top();
-            if (task->mValid.load() && task->mTime > now) {
+            task = mTaskQueue->popExpired(GTime::currentSteadyTime().nanosecond());
+            if (!task) {
                 break;
             }
-            mTaskQueue.pop();
-        }
-        GTimerEvent event;
-        if (task && task->mValid.load() && ((event = task->mEvent))) {
-            auto pushQueue = [&] {
-                task->mTime.update();
-                task->mTime.addMilliSecs(task->mInterval); {
-                    GLocker<GMutex> locker(mLock);
-                    mTaskQueue.push(task);
-                }
-            };
-            if (task->mCondition && !task->mCondition()) {
-                pushQueue();
-            } else {
-                event();
-                if (!task->mOneShot && task->mValid.load()) {
-                    pushQueue();
-                }
-            }
         }
+        executeTask(task);
         if (GTime::currentSteadyTime().milliSecsTo(beginTime) > maxTime) {
             break;
         }
@@ -180,6 +207,30 @@ int64_t GTimerScheduler::loop(int64_t maxTime)
     return GTime::currentSteadyTime().milliSecsTo(beginTime);
 }
 
+GTimerScheduler::WakeupStats GTimerScheduler::wakeupStats() const
+{
+    WakeupStats stats;
+    stats.wakeups = mWakeups.load(std::memory_order_relaxed);
+    stats.firedTasks = mFiredTasks.load(std::memory_order_relaxed);
+    stats.seconds = static_cast<double>(GTime::currentSteadyTime().nanosecond() - mStatsBeginTime.load()) / 1e9;
+    return stats;
+}
+
+GTimerScheduler::WakeupStats GTimerScheduler::takeWakeupStats()
+{
+    const int64_t now = GTime::currentSteadyTime().nanosecond();
+    WakeupStats stats;
+    stats.wakeups = mWakeups.exchange(0, std::memory_order_relaxed);
+    stats.firedTasks = mFiredTasks.exchange(0, std::memory_order_relaxed);
+    stats.seconds = static_cast<double>(now - mStatsBeginTime.exchange(now)) / 1e9;
+    return stats;
+}
+
+void GTimerScheduler::resetWakeupStats()
+{
+    takeWakeupStats();
+}
+
 void GTimerScheduler::start()
 {
     mIsRunning.store(true);
@@ -187,14 +238,13 @@ void GTimerScheduler::start()
 
 void GTimerScheduler::stop(bool wait)
 {
+    std::vector<GTimerTaskPtr> tasks;
     if (mIsRunning.exchange(false)) {
         GLockerGuard locker(mLock);
         if (!wait) {
-            while (!mTaskQueue.empty()) {
-                mTaskQueue.pop();
-            }
+            tasks = mTaskQueue->clear();
         }
-        mTaskCond.notify_all();
+        mWaiter->notify();
     }
 }
 
@@ -204,10 +254,37 @@ bool GTimerScheduler::isRunning() const
 }
 
 GTimerScheduler::GTimerTaskPtr GTimerScheduler::post(GTimerEvent event, int64_t delay)
+{
+    return addTask(std::move(event), nullptr, delay * NANOS_PER_MILLI, 0, true);
+}
+
+GTimerScheduler::GTimerTaskPtr GTimerScheduler::postMicroSecs(GTimerEvent event, int64_t delay)
+{
+    return addTask(std::move(event), nullptr, delay * NANOS_PER_MICRO, 0, true);
+}
+
+GTimerScheduler::GTimerTaskPtr GTimerScheduler::postNanoSecs(GTimerEvent event, int64_t delay)
 {
     return addTask(std::move(event), nullptr, delay, 0, true);
 }
 
+GTimerScheduler::Backend GTimerScheduler::backend() const
+{
+    return mBackend;
+}
+
+size_t GTimerScheduler::taskCount() const
+{
+    GLockerGuard locker(mLock);
+    return mTaskQueue->size();
+}
+
+size_t GTimerScheduler::deadTaskCount() const
+{
+    GLockerGuard locker(mLock);
+    return mTaskQueue->deadCount();
+}
+
 GTimerScheduler::GTimerTaskPtr GTimerScheduler::addTask(GTimerEvent event,
                                                         GTimerCondition condition,
                                                         int64_t delay,
@@ -216,12 +293,263 @@ GTimerScheduler::GTimerTaskPtr GTimerScheduler::addTask(GTimerEvent event,
 {
     auto task = std::shared_ptr<GTimerTask>(new GTimerTask(std::move(event), std::move(condition), delay, interval));
     task->mOneShot = oneShot;
-    GLockerGuard locker(mLock);
-    mTaskQueue.push(task);
-    mTaskCond.notify_one();
+    scheduleTask(task);
     return task;
 }
 
+void GTimerScheduler::scheduleTask(const GTimerTaskPtr &task)
+{
+    task->mScheduler = weak_from_this();
+    GLockerGuard locker(mLock);
+    mTaskQueue->push(task);
+    mWaiter->notify();
+}
+
+void GTimerScheduler::removeTask(GTimerTask *task)
+{
+    // Released after the lock, the task may own objects whose destructors use the scheduler
+    GTimerTaskPtr removed;
+    GLockerGuard locker(mLock);
+    removed = mTaskQueue->remove(task);
+}
+
+void GTimerScheduler::pushTask(const GTimerTaskPtr &task, int64_t ticks, bool notify)
+{
+    if (task->mSchedule == GTimerSchedule::FixedRate) {
+        // Advance from the previous deadline, not from now, so the callback latency does not accumulate
+        task->mTime.addNanoSecs(ticks * task->mInterval);
+    } else {
+        task->mTime.update();
+        task->mTime.addNanoSecs(task->mInterval);
+    }
+
+    GLockerGuard locker(mLock);
+    // Checked under the lock, cancel() may have run while the task was executing
+    if (task->mValid.load()) {
+        mTaskQueue->push(task);
+        if (notify) {
+            mWaiter->notify();
+        }
+    }
+}
+
+void GTimerScheduler::executeTask(const GTimerTaskPtr &task)
+{
+    GTimerCondition condition;
+    {
+        GLockerGuard locker(task->mRunLock);
+        if (!task->mValid.load() || (!task->mTickEvent && !task->mEvent)) {
+            return;
+        }
+        condition = task->mCondition;
+        if (condition) {
+            task->mInFlight.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    mFiredTasks.fetch_add(1, std::memory_order_relaxed);
+
+    // Whole intervals elapsed since the deadline, only fixed-rate timers keep count of them
+    int64_t overdue = 0;
+    const bool fixedRate = task->mSchedule == GTimerSchedule::FixedRate && task->mInterval > 0;
+    if (fixedRate) {
+        const int64_t late = GTime::currentSteadyTime().nanoSecsTo(task->mTime);
+        overdue = late > 0 ? late / task->mInterval : 0;
+    }
+
+    if (condition) {
+        bool pass;
+        {
+            GTimerRunScope scope(task->mInFlight, task.get());
+            pass = condition();
+        }
+        if (!pass) {
+            pushTask(task, overdue + 1);
+            return;
+        }
+    }
+
+    int64_t missed = 0;
+    int64_t ticks = 1;
+    switch (task->mMissedTickPolicy) {
+        case GTimerMissedTickPolicy::FireAll:
+            missed = overdue;
+            break;
+        case GTimerMissedTickPolicy::Coalesce:
+            missed = overdue;
+            ticks = overdue + 1;
+            break;
+        case GTimerMissedTickPolicy::Skip:
+            if (overdue > 0 && !task->mOneShot) {
+                task->mSkippedTicks += overdue + 1;
+                pushTask(task, overdue + 1);
+                return;
+            }
+            break;
+    }
+    const int64_t skipped = task->mSkippedTicks;
+    missed += skipped;
+    task->mSkippedTicks = 0;
+
+    const GTimerExecutor &executor = task->mExecutor ? task->mExecutor : mExecutor;
+    if (!executor) {
+        runTask(task, missed);
+        if (!task->mOneShot) {
+            pushTask(task, ticks);
+        }
+        return;
+    }
+
+    // A fixed-rate deadline does not depend on the run, re-arm now so the next tick is not delayed by the executor
+    if (fixedRate && !task->mOneShot) {
+        pushTask(task, ticks);
+    }
+    if (!dispatchTask(task, executor, missed)) {
+        task->mSkippedTicks += skipped + ticks;
+    }
+}
+
+bool GTimerScheduler::dispatchTask(const GTimerTaskPtr &task, const GTimerExecutor &executor, int64_t missedTicks)
+{
+    // Fixed-delay timers are re-armed once the run is over, the interval starts from the end of the run
+    const bool rearm = !task->mOneShot && !(task->mSchedule == GTimerSchedule::FixedRate && task->mInterval > 0);
+    const GTimerEvent finish = [task, rearm] {
+        if (!rearm) {
+            return;
+        }
+        const auto scheduler = task->mScheduler.lock();
+        if (scheduler) {
+            scheduler->pushTask(task, 1, true);
+        }
+    };
+
+    switch (task->mConcurrency) {
+        case GTimerConcurrency::Parallel: {
+            executor([task, missedTicks, finish] {
+                runTask(task, missedTicks);
+                finish();
+            });
+            return true;
+        }
+        case GTimerConcurrency::SkipOverlap: {
+            {
+                GLockerGuard locker(task->mRunLock);
+                if (task->mRunning) {
+                    return false;
+                }
+                task->mRunning = true;
+            }
+            executor([task, missedTicks, finish] {
+                runTask(task, missedTicks);
+                {
+                    GLockerGuard locker(task->mRunLock);
+                    task->mRunning = false;
+                }
+                finish();
+            });
+            return true;
+        }
+        case GTimerConcurrency::Serial:
+        default: {
+            {
+                GLockerGuard locker(task->mRunLock);
+                task->mPendingRuns.push_back(missedTicks);
+                if (task->mRunning) {
+                    return true;
+                }
+                task->mRunning = true;
+            }
+            drainTask(task, executor, finish);
+            return true;
+        }
+    }
+}
+
+void GTimerScheduler::drainTask(const GTimerTaskPtr &task, const GTimerExecutor &executor, const GTimerEvent &finish)
+{
+    // One drain per timer at a time, it runs the queued batch in order and then re-submits itself
+    // instead of looping, so a timer that keeps falling behind does not hold an executor thread forever
+    executor([task, executor, finish] {
+        std::vector<int64_t> runs;
+        {
+            GLockerGuard locker(task->mRunLock);
+            runs.swap(task->mPendingRuns);
+        }
+        for (const int64_t missed: runs) {
+            runTask(task, missed);
+        }
+        bool more;
+        {
+            GLockerGuard locker(task->mRunLock);
+            more = !task->mPendingRuns.empty();
+            task->mRunning = more;
+        }
+        if (more) {
+            drainTask(task, executor, finish);
+        } else {
+            finish();
+        }
+    });
+}
+
+void GTimerScheduler::runTask(const GTimerTaskPtr &task, int64_t missedTicks)
+{
+    // Copied under the lock, cancel() and GTimer replace the events from other threads
+    GTimerTickEvent tickEvent;
+    GTimerEvent event;
+    {
+        GLockerGuard locker(task->mRunLock);
+        if (!task->mValid.load()) {
+            return;
+        }
+        tickEvent = task->mTickEvent;
+        if (!tickEvent) {
+            event = task->mEvent;
+        }
+        task->mInFlight.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    GTimerRunScope scope(task->mInFlight, task.get());
+    if (tickEvent) {
+        tickEvent(missedTicks);
+    } else if (event) {
+        event();
+    }
+}
+
+GTimerExecutor GTimerScheduler::executorOf(GTaskSystem *taskSystem, bool front)
+{
+    GX_ASSERT(taskSystem);
+    if (front) {
+        return [taskSystem](std::function<void()> run) {
+            taskSystem->submitFront(run);
+        };
+    }
+    return [taskSystem](std::function<void()> run) {
+        taskSystem->submit(run);
+    };
+}
+
+GTimerExecutor GTimerScheduler::executorOf(GJobSystem *jobSystem)
+{
+    GX_ASSERT(jobSystem);
+    return [jobSystem](std::function<void()> run) {
+        // adopt() looks the thread up under the thread map lock, do it once per thread
+        static thread_local const GJobSystem *tAdopted = nullptr;
+        if (tAdopted != jobSystem) {
+            jobSystem->adopt();
+            tAdopted = jobSystem;
+        }
+        GJobSystem::Job *job = jobSystem->createJob(nullptr, [run](GJobSystem *, GJobSystem::Job *) {
+            run();
+        });
+        if (job) {
+            jobSystem->run(job);
+        } else {
+            LogW("GTimerScheduler: job pool is exhausted, run the timer event inline.");
+            run();
+        }
+    };
+}
 
 GTimer::GTimer(const std::shared_ptr<GTimerScheduler> &scheduler, bool oneShot)
     : mScheduler(scheduler),
@@ -250,9 +578,15 @@ GTimer::~GTimer()
 GTimer::GTimer(GTimer &&rh) noexcept
     : mScheduler(std::move(rh.mScheduler)),
       mEvent(std::move(rh.mEvent)),
+      mTickEvent(std::move(rh.mTickEvent)),
       mCondition(std::move(rh.mCondition)),
       mTask(std::move(rh.mTask)),
-      mOneShot(rh.mOneShot)
+      mOneShot(rh.mOneShot),
+      mSchedule(rh.mSchedule),
+      mMissedTickPolicy(rh.mMissedTickPolicy),
+      mExecutor(std::move(rh.mExecutor)),
+      mConcurrency(rh.mConcurrency),
+      mSlack(rh.mSlack)
 {
 }
 
@@ -261,9 +595,15 @@ GTimer &GTimer::operator=(GTimer &&rh) noexcept
     if (this != &rh) {
         mScheduler = std::move(rh.mScheduler);
         mEvent = std::move(rh.mEvent);
+        mTickEvent = std::move(rh.mTickEvent);
         mCondition = std::move(rh.mCondition);
         mTask = std::move(rh.mTask);
         mOneShot = rh.mOneShot;
+        mSchedule = rh.mSchedule;
+        mMissedTickPolicy = rh.mMissedTickPolicy;
+        mExecutor = std::move(rh.mExecutor);
+        mConcurrency = rh.mConcurrency;
+        mSlack = rh.mSlack;
     }
     return *this;
 }
@@ -289,10 +629,24 @@ void GTimer::timerEvent(GTimerEvent event)
     }
     const auto taskPtr = mTask.lock();
     if (taskPtr && taskPtr->mValid.load()) {
+        GLockerGuard locker(taskPtr->mRunLock);
         taskPtr->mEvent = mEvent;
     }
 }
 
+void GTimer::timerTickEvent(GTimerTickEvent event)
+{
+    mTickEvent = std::move(event);
+    if (mTask.expired()) {
+        return;
+    }
+    const auto taskPtr = mTask.lock();
+    if (taskPtr && taskPtr->mValid.load()) {
+        GLockerGuard locker(taskPtr->mRunLock);
+        taskPtr->mTickEvent = mTickEvent;
+    }
+}
+
 void GTimer::setCondition(GTimerCondition cond)
 {
     if (!cond) {
@@ -305,6 +659,7 @@ void GTimer::setCondition(GTimerCondition cond)
     }
     const auto task = mTask.lock();
     if (task && task->mValid.load()) {
+        GLockerGuard locker(task->mRunLock);
         task->mCondition = mCondition;
     }
 }
@@ -321,6 +676,37 @@ void GTimer::setOneShot(bool oneShot)
     }
 }
 
+void GTimer::setSchedule(GTimerSchedule schedule)
+{
+    mSchedule = schedule;
+}
+
+void GTimer::setMissedTickPolicy(GTimerMissedTickPolicy policy)
+{
+    mMissedTickPolicy = policy;
+}
+
+void GTimer::setSlack(int64_t slack)
+{
+    setSlackNanoSecs(slack * NANOS_PER_MILLI);
+}
+
+void GTimer::setSlackMicroSecs(int64_t slack)
+{
+    setSlackNanoSecs(slack * NANOS_PER_MICRO);
+}
+
+void GTimer::setSlackNanoSecs(int64_t slack)
+{
+    mSlack = std::max<int64_t>(slack, 0);
+}
+
+void GTimer::setExecutor(GTimerExecutor executor, GTimerConcurrency concurrency)
+{
+    mExecutor = std::move(executor);
+    mConcurrency = concurrency;
+}
+
 void GTimer::start(int64_t interval)
 {
     start(interval, interval);
@@ -328,7 +714,27 @@ void GTimer::start(int64_t interval)
 
 void GTimer::start(int64_t delay, int64_t interval)
 {
-    if (!mEvent) {
+    startNanoSecs(delay * NANOS_PER_MILLI, interval * NANOS_PER_MILLI);
+}
+
+void GTimer::startMicroSecs(int64_t interval)
+{
+    startMicroSecs(interval, interval);
+}
+
+void GTimer::startMicroSecs(int64_t delay, int64_t interval)
+{
+    startNanoSecs(delay * NANOS_PER_MICRO, interval * NANOS_PER_MICRO);
+}
+
+void GTimer::startNanoSecs(int64_t interval)
+{
+    startNanoSecs(interval, interval);
+}
+
+void GTimer::startNanoSecs(int64_t delay, int64_t interval)
+{
+    if (!mEvent && !mTickEvent) {
         return;
     }
     stop();
@@ -336,7 +742,16 @@ void GTimer::start(int64_t delay, int64_t interval)
     GX_ASSERT_S(!mScheduler.expired(), "GTimer: Invalid scheduler");
     const auto scheduler = mScheduler.lock();
     if (scheduler) {
-        mTask = scheduler->addTask(mEvent, mCondition, delay, interval, mOneShot);
+        auto task = std::shared_ptr<GTimerTask>(new GTimerTask(mEvent, mCondition, delay, interval));
+        task->mTickEvent = mTickEvent;
+        task->mOneShot = mOneShot;
+        task->mSchedule = mSchedule;
+        task->mMissedTickPolicy = mMissedTickPolicy;
+        task->mExecutor = mExecutor;
+        task->mConcurrency = mConcurrency;
+        task->mSlack = mSlack;
+        mTask = task;
+        scheduler->scheduleTask(task);
     }
 }
 
@@ -348,6 +763,8 @@ void GTimer::stop()
     const auto taskPtr = mTask.lock();
     if (taskPtr) {
         taskPtr->cancel();
+        // The runs already started may still call into this object
+        taskPtr->waitRuns();
         mTask.reset();
     }
 }
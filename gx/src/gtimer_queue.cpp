@@ -0,0 +1,338 @@
+//
+// Created by Gxin on 2024/3/20.
+//
+
+#include "gtimer_queue.h"
+
+#include "gx/debug.h"
+
+#include <algorithm>
+#include <bit>
+
+
+int64_t GTimerQueue::latestDeadline(const GTimerTask *task)
+{
+    return task->mTime.nanosecond() + task->mSlack;
+}
+
+// ------------------------------------------------------------------------------------------------
+// GTimerHeapQueue
+// ------------------------------------------------------------------------------------------------
+
+void GTimerHeapQueue::push(const GTimerTaskPtr &task)
+{
+    task->mSlot = LIVE_SLOT;
+    mHeap.push_back(task);
+    std::push_heap(mHeap.begin(), mHeap.end(), compare);
+}
+
+GTimerQueue::GTimerTaskPtr GTimerHeapQueue::remove(GTimerTask *task)
+{
+    if (task->mSlot != LIVE_SLOT) {
+        return nullptr;
+    }
+    task->mSlot = DEAD_SLOT;
+    ++mDeadCount;
+    if (mDeadCount >= COMPACT_MIN_DEAD && mDeadCount * 2 > mHeap.size()) {
+        compact();
+    }
+    return nullptr;
+}
+
+GTimerQueue::GTimerTaskPtr GTimerHeapQueue::popExpired(int64_t now)
+{
+    if (mHeap.empty()) {
+        return nullptr;
+    }
+    const GTimerTaskPtr &top = mHeap.front();
+    if (top->mValid.load() && top->mTime.nanosecond() > now) {
+        return nullptr;
+    }
+    std::pop_heap(mHeap.begin(), mHeap.end(), compare);
+    GTimerTaskPtr task = std::move(mHeap.back());
+    mHeap.pop_back();
+    if (task->mSlot == DEAD_SLOT) {
+        --mDeadCount;
+    }
+    task->mSlot = -1;
+    return task;
+}
+
+int64_t GTimerHeapQueue::nextDeadline()
+{
+    if (mHeap.empty()) {
+        return NO_DEADLINE;
+    }
+    const GTimerTaskPtr &top = mHeap.front();
+    return top->mValid.load() ? latestDeadline(top.get()) : 0;
+}
+
+size_t GTimerHeapQueue::size() const
+{
+    return mHeap.size() - mDeadCount;
+}
+
+size_t GTimerHeapQueue::deadCount() const
+{
+    return mDeadCount;
+}
+
+std::vector<GTimerQueue::GTimerTaskPtr> GTimerHeapQueue::clear()
+{
+    std::vector<GTimerTaskPtr> tasks;
+    tasks.swap(mHeap);
+    for (const auto &task: tasks) {
+        task->mSlot = -1;
+    }
+    mDeadCount = 0;
+    return tasks;
+}
+
+void GTimerHeapQueue::compact()
+{
+    // The cancelled tasks have already released their event and condition, dropping them here is cheap
+    const auto it = std::remove_if(mHeap.begin(), mHeap.end(), [](const GTimerTaskPtr &task) {
+        if (task->mSlot == DEAD_SLOT) {
+            task->mSlot = -1;
+            return true;
+        }
+        return false;
+    });
+    mHeap.erase(it, mHeap.end());
+    std::make_heap(mHeap.begin(), mHeap.end(), compare);
+    mDeadCount = 0;
+}
+
+bool GTimerHeapQueue::compare(const GTimerTaskPtr &lhs, const GTimerTaskPtr &rhs)
+{
+    return latestDeadline(lhs.get()) > latestDeadline(rhs.get());
+}
+
+// ------------------------------------------------------------------------------------------------
+// GTimerWheelQueue
+// ------------------------------------------------------------------------------------------------
+
+GTimerWheelQueue::GTimerWheelQueue(int64_t tickNs, int64_t now)
+    : mTickNs(tickNs),
+      mCurrentTick(now / tickNs)
+{
+    GX_ASSERT(tickNs > 0);
+}
+
+GTimerWheelQueue::~GTimerWheelQueue()
+{
+    clear();
+}
+
+void GTimerWheelQueue::push(const GTimerTaskPtr &task)
+{
+    GX_ASSERT(task->mSlot < 0);
+    task->mQueueRef = task;
+    task->mExpireTick = expireTick(task.get());
+    insert(task.get());
+    ++mCount;
+}
+
+GTimerQueue::GTimerTaskPtr GTimerWheelQueue::remove(GTimerTask *task)
+{
+    if (task->mSlot < 0) {
+        return nullptr;
+    }
+    unlink(task);
+    --mCount;
+    return std::move(task->mQueueRef);
+}
+
+GTimerQueue::GTimerTaskPtr GTimerWheelQueue::popExpired(int64_t now)
+{
+    advance(now / mTickNs);
+
+    GTimerTask *task = mHead[READY_SLOT];
+    if (!task) {
+        return nullptr;
+    }
+    unlink(task);
+    --mCount;
+    return std::move(task->mQueueRef);
+}
+
+int64_t GTimerWheelQueue::nextDeadline()
+{
+    if (mHead[READY_SLOT]) {
+        return 0;
+    }
+    const int64_t tick = nextEventTick();
+    return tick == NO_DEADLINE ? NO_DEADLINE : tick * mTickNs;
+}
+
+size_t GTimerWheelQueue::size() const
+{
+    return mCount;
+}
+
+size_t GTimerWheelQueue::deadCount() const
+{
+    // Cancelled tasks are unlinked immediately
+    return 0;
+}
+
+std::vector<GTimerQueue::GTimerTaskPtr> GTimerWheelQueue::clear()
+{
+    std::vector<GTimerTaskPtr> tasks;
+    tasks.reserve(mCount);
+    for (int32_t slot = 0; slot <= READY_SLOT; slot++) {
+        while (GTimerTask *task = mHead[slot]) {
+            unlink(task);
+            tasks.push_back(std::move(task->mQueueRef));
+        }
+    }
+    mCount = 0;
+    return tasks;
+}
+
+int64_t GTimerWheelQueue::expireTick(const GTimerTask *task) const
+{
+    // Round up, a task never fires before its deadline
+    const int64_t expires = (task->mTime.nanosecond() + mTickNs - 1) / mTickNs;
+    const int64_t limit = latestDeadline(task) / mTickNs;
+    if (limit <= expires) {
+        return expires;
+    }
+    // Pick the tick in [expires, limit] with the most trailing zero bits, the timers with overlapping windows
+    // then land on the same coarse tick and are expired together (the former Linux timer wheel apply_slack())
+    const int32_t bit = 63 - std::countl_zero(static_cast<uint64_t>(expires ^ limit));
+    return limit & ~((int64_t(1) << bit) - 1);
+}
+
+void GTimerWheelQueue::insert(GTimerTask *task)
+{
+    if (task->mExpireTick < mCurrentTick) {
+        link(task, READY_SLOT);
+        return;
+    }
+    int64_t expires = task->mExpireTick;
+    const int64_t idx = expires - mCurrentTick;
+
+    int32_t level = 0;
+    while (level < LEVEL_COUNT - 1 && idx >= (int64_t(1) << (SLOT_BITS * (level + 1)))) {
+        level++;
+    }
+    // Park tasks beyond the wheel range in the farthest slot, they are re-inserted when cascaded
+    const int64_t range = int64_t(1) << (SLOT_BITS * LEVEL_COUNT);
+    if (idx >= range) {
+        expires = mCurrentTick + range - 1;
+    }
+    const auto index = static_cast<int32_t>((expires >> (SLOT_BITS * level)) & (SLOT_COUNT - 1));
+    link(task, level * SLOT_COUNT + index);
+}
+
+void GTimerWheelQueue::link(GTimerTask *task, int32_t slot)
+{
+    task->mSlot = slot;
+    task->mNext = nullptr;
+    task->mPrev = mTail[slot];
+    if (mTail[slot]) {
+        mTail[slot]->mNext = task;
+    } else {
+        mHead[slot] = task;
+    }
+    mTail[slot] = task;
+    if (slot < READY_SLOT) {
+        mOccupied[slot / SLOT_COUNT] |= uint64_t(1) << (slot % SLOT_COUNT);
+    }
+}
+
+void GTimerWheelQueue::unlink(GTimerTask *task)
+{
+    const int32_t slot = task->mSlot;
+    if (task->mPrev) {
+        task->mPrev->mNext = task->mNext;
+    } else {
+        mHead[slot] = task->mNext;
+    }
+    if (task->mNext) {
+        task->mNext->mPrev = task->mPrev;
+    } else {
+        mTail[slot] = task->mPrev;
+    }
+    if (!mHead[slot] && slot < READY_SLOT) {
+        mOccupied[slot / SLOT_COUNT] &= ~(uint64_t(1) << (slot % SLOT_COUNT));
+    }
+    task->mPrev = nullptr;
+    task->mNext = nullptr;
+    task->mSlot = -1;
+}
+
+void GTimerWheelQueue::advance(int64_t nowTick)
+{
+    while (true) {
+        const int64_t tick = nextEventTick();
+        if (tick > nowTick) {
+            break;
+        }
+        mCurrentTick = tick;
+        for (int32_t level = LEVEL_COUNT - 1; level > 0; level--) {
+            const int32_t shift = SLOT_BITS * level;
+            if ((tick & ((int64_t(1) << shift) - 1)) == 0) {
+                cascade(level, static_cast<int32_t>((tick >> shift) & (SLOT_COUNT - 1)));
+            }
+        }
+        const auto slot = static_cast<int32_t>(tick & (SLOT_COUNT - 1));
+        while (GTimerTask *task = mHead[slot]) {
+            unlink(task);
+            link(task, READY_SLOT);
+        }
+        mCurrentTick = tick + 1;
+    }
+    // No slot needs service up to nowTick, skip the empty ticks
+    if (mCurrentTick <= nowTick) {
+        mCurrentTick = nowTick + 1;
+    }
+}
+
+void GTimerWheelQueue::cascade(int32_t level, int32_t index)
+{
+    const int32_t slot = level * SLOT_COUNT + index;
+    GTimerTask *task = mHead[slot];
+    if (!task) {
+        return;
+    }
+    // Detach the whole list first, tasks parked beyond the range may land in the same slot again
+    mHead[slot] = nullptr;
+    mTail[slot] = nullptr;
+    mOccupied[level] &= ~(uint64_t(1) << index);
+    while (task) {
+        GTimerTask *next = task->mNext;
+        insert(task);
+        task = next;
+    }
+}
+
+int64_t GTimerWheelQueue::nextEventTick() const
+{
+    int64_t best = NO_DEADLINE;
+    for (int32_t level = 0; level < LEVEL_COUNT; level++) {
+        const uint64_t mask = mOccupied[level];
+        if (!mask) {
+            continue;
+        }
+        const int32_t shift = SLOT_BITS * level;
+        const int64_t base = (mCurrentTick >> (shift + SLOT_BITS)) << (shift + SLOT_BITS);
+        const auto current = static_cast<int32_t>((mCurrentTick >> shift) & (SLOT_COUNT - 1));
+
+        // The current slot of an upper level is only due when the current tick is at its boundary,
+        // otherwise it holds tasks of the next rotation
+        const bool aligned = (mCurrentTick & ((int64_t(1) << shift) - 1)) == 0;
+        const int32_t from = aligned ? current : current + 1;
+        const uint64_t ahead = from < SLOT_COUNT ? mask & (~uint64_t(0) << from) : 0;
+
+        int64_t tick;
+        if (ahead) {
+            tick = base + (int64_t(std::countr_zero(ahead)) << shift);
+        } else {
+            tick = base + (int64_t(1) << (shift + SLOT_BITS)) + (int64_t(std::countr_zero(mask)) << shift);
+        }
+        best = std::min(best, tick);
+    }
+    return best;
+}
@@ -0,0 +1,175 @@
+//
+// Created by Gxin on 2024/3/20.
+//
+
+#ifndef GX_GTIMER_QUEUE_H
+#define GX_GTIMER_QUEUE_H
+
+#include "gx/gtimer.h"
+
+#include <limits>
+#include <vector>
+
+
+/**
+ * @brief Storage of the pending tasks of a GTimerScheduler.
+ * Not thread safe, always accessed with the scheduler lock held.
+ */
+class GTimerQueue
+{
+public:
+    using GTimerTaskPtr = GTimerScheduler::GTimerTaskPtr;
+
+    static constexpr int64_t NO_DEADLINE = std::numeric_limits<int64_t>::max();
+
+public:
+    virtual ~GTimerQueue() = default;
+
+    virtual void push(const GTimerTaskPtr &task) = 0;
+
+    /**
+     * @brief Remove a task that is still queued
+     * @param task
+     * @return The removed task, nullptr if it is not in the queue or the backend removes it lazily
+     */
+    virtual GTimerTaskPtr remove(GTimerTask *task) = 0;
+
+    /**
+     * @brief Pop one task whose deadline is not later than now, invalid tasks are popped too.
+     * A task with slack may be popped anywhere in [deadline, deadline + slack].
+     * @param now   Steady time in nanoseconds
+     * @return
+     */
+    virtual GTimerTaskPtr popExpired(int64_t now) = 0;
+
+    /**
+     * @brief Time (steady nanoseconds) when the queue needs to be serviced next,
+     * it may be earlier than the earliest deadline
+     * @return NO_DEADLINE if the queue is empty
+     */
+    virtual int64_t nextDeadline() = 0;
+
+    virtual size_t size() const = 0;
+
+    /**
+     * @brief Number of cancelled tasks that are still held by the queue
+     */
+    virtual size_t deadCount() const = 0;
+
+    /**
+     * @brief Remove all tasks
+     * @return The removed tasks, released by the caller outside the scheduler lock
+     */
+    virtual std::vector<GTimerTaskPtr> clear() = 0;
+
+protected:
+    /**
+     * @brief deadline + slack, the task must have expired by then
+     */
+    static int64_t latestDeadline(const GTimerTask *task);
+};
+
+
+/**
+ * @brief Binary heap ordered by the latest deadline (deadline + slack), like Linux hrtimers.
+ * The scheduler wakes up for the top task's latest deadline and then pops every task at the top
+ * whose own deadline has passed, so the timers with overlapping windows expire in one wakeup.
+ * Cancelled tasks are marked as tombstones (O(1)) and dropped when they reach the top,
+ * once tombstones make up more than half of the heap it is compacted in O(n),
+ * so cancel stays amortized O(1) and dead entries never dominate push/pop.
+ */
+class GTimerHeapQueue final : public GTimerQueue
+{
+public:
+    static constexpr int32_t LIVE_SLOT = 0;
+    static constexpr int32_t DEAD_SLOT = 1;
+    static constexpr size_t COMPACT_MIN_DEAD = 64;
+
+public:
+    void push(const GTimerTaskPtr &task) override;
+
+    GTimerTaskPtr remove(GTimerTask *task) override;
+
+    GTimerTaskPtr popExpired(int64_t now) override;
+
+    int64_t nextDeadline() override;
+
+    size_t size() const override;
+
+    size_t deadCount() const override;
+
+    std::vector<GTimerTaskPtr> clear() override;
+
+private:
+    void compact();
+
+    static bool compare(const GTimerTaskPtr &lhs, const GTimerTaskPtr &rhs);
+
+private:
+    std::vector<GTimerTaskPtr> mHeap;
+    size_t mDeadCount = 0;
+};
+
+
+/**
+ * @brief Hierarchical timing wheel (Varghese & Lauck).
+ * LEVEL_COUNT levels of 64 slots, every level covers 64 times the range of the previous one.
+ * Tasks are kept in intrusive doubly linked lists so insert and cancel are O(1),
+ * a 64-bit occupancy mask per level lets empty ticks be skipped without scanning slots.
+ * Tasks beyond the range of the top level are parked in it and re-inserted when cascaded.
+ * The slack of a task is used to round its tick to a coarse boundary, see expireTick().
+ */
+class GTimerWheelQueue final : public GTimerQueue
+{
+public:
+    static constexpr int32_t SLOT_BITS = 6;
+    static constexpr int32_t SLOT_COUNT = 1 << SLOT_BITS;
+    static constexpr int32_t LEVEL_COUNT = 5;
+    static constexpr int32_t READY_SLOT = LEVEL_COUNT * SLOT_COUNT;
+
+public:
+    explicit GTimerWheelQueue(int64_t tickNs, int64_t now);
+
+    ~GTimerWheelQueue() override;
+
+public:
+    void push(const GTimerTaskPtr &task) override;
+
+    GTimerTaskPtr remove(GTimerTask *task) override;
+
+    GTimerTaskPtr popExpired(int64_t now) override;
+
+    int64_t nextDeadline() override;
+
+    size_t size() const override;
+
+    size_t deadCount() const override;
+
+    std::vector<GTimerTaskPtr> clear() override;
+
+private:
+    int64_t expireTick(const GTimerTask *task) const;
+
+    void insert(GTimerTask *task);
+
+    void link(GTimerTask *task, int32_t slot);
+
+    void unlink(GTimerTask *task);
+
+    void advance(int64_t nowTick);
+
+    void cascade(int32_t level, int32_t index);
+
+    int64_t nextEventTick() const;
+
+private:
+    const int64_t mTickNs;
+    int64_t mCurrentTick;   // Next tick to be processed
+    size_t mCount = 0;
+
+    GTimerTask *mHead[READY_SLOT + 1]{};
+    GTimerTask *mTail[READY_SLOT + 1]{};
+    uint64_t mOccupied[LEVEL_COUNT]{};
+};
+
+#endif //GX_GTIMER_QUEUE_H
@@ -0,0 +1,148 @@
+//
+// Created by Gxin on 2024/3/23.
+//
+
+#include "gtimer_waiter.h"
+
+#include "gtimer_queue.h"
+
+#include "gx/debug.h"
+
+#include <chrono>
+#include <thread>
+
+#if GX_PLATFORM_LINUX
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#endif
+
+
+static int64_t steadyNow()
+{
+    return GTime::currentSteadyTime().nanosecond();
+}
+
+std::unique_ptr<GTimerWaiter> GTimerWaiter::create(GTimerScheduler::WaitMode mode, int64_t spinTime)
+{
+#if GX_PLATFORM_LINUX
+    if (mode == GTimerScheduler::WaitMode::Precise) {
+        auto waiter = std::make_unique<GTimerFdWaiter>(spinTime);
+        if (waiter->isValid()) {
+            return waiter;
+        }
+        LogW("GTimerScheduler: timerfd is not available, fall back to condition variable.");
+    }
+#endif
+    return std::make_unique<GTimerCondWaiter>(spinTime);
+}
+
+// ------------------------------------------------------------------------------------------------
+// GTimerCondWaiter
+// ------------------------------------------------------------------------------------------------
+
+GTimerCondWaiter::GTimerCondWaiter(int64_t spinTime)
+    : mSpinTime(spinTime > 0 ? spinTime : 0)
+{
+}
+
+void GTimerCondWaiter::wait(GLocker<GMutex> &locker, int64_t deadline)
+{
+    if (deadline == GTimerQueue::NO_DEADLINE) {
+        mCond.wait(locker);
+        return;
+    }
+    const int64_t sleepUntil = deadline - mSpinTime;
+    if (steadyNow() < sleepUntil) {
+        mCond.wait_until(locker, std::chrono::steady_clock::time_point(std::chrono::nanoseconds(sleepUntil)));
+        return;
+    }
+    spinUntil(locker, deadline);
+}
+
+void GTimerCondWaiter::notify()
+{
+    mCond.notify_all();
+}
+
+void GTimerCondWaiter::spinUntil(GLocker<GMutex> &locker, int64_t deadline) const
+{
+    locker.unlock();
+    while (steadyNow() < deadline) {
+        std::this_thread::yield();
+    }
+    locker.lock();
+}
+
+// ------------------------------------------------------------------------------------------------
+// GTimerFdWaiter
+// ------------------------------------------------------------------------------------------------
+
+#if GX_PLATFORM_LINUX
+
+GTimerFdWaiter::GTimerFdWaiter(int64_t spinTime)
+    : GTimerCondWaiter(spinTime)
+{
+    mTimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    mEventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+}
+
+GTimerFdWaiter::~GTimerFdWaiter()
+{
+    if (mTimerFd >= 0) {
+        close(mTimerFd);
+    }
+    if (mEventFd >= 0) {
+        close(mEventFd);
+    }
+}
+
+bool GTimerFdWaiter::isValid() const
+{
+    return mTimerFd >= 0 && mEventFd >= 0;
+}
+
+void GTimerFdWaiter::wait(GLocker<GMutex> &locker, int64_t deadline)
+{
+    itimerspec spec{};
+    if (deadline != GTimerQueue::NO_DEADLINE) {
+        const int64_t sleepUntil = deadline - mSpinTime;
+        if (steadyNow() >= sleepUntil) {
+            spinUntil(locker, deadline);
+            return;
+        }
+        spec.it_value.tv_sec = static_cast<time_t>(sleepUntil / 1000000000);
+        spec.it_value.tv_nsec = static_cast<long>(sleepUntil % 1000000000);
+    }
+    // A zero it_value disarms the timer
+    timerfd_settime(mTimerFd, TFD_TIMER_ABSTIME, &spec, nullptr);
+
+    locker.unlock();
+
+    pollfd fds[2] = {
+        {mTimerFd, POLLIN, 0},
+        {mEventFd, POLLIN, 0}
+    };
+    ::poll(fds, 2, -1);
+
+    uint64_t value;
+    if (fds[0].revents & POLLIN) {
+        (void) !::read(mTimerFd, &value, sizeof(value));
+    }
+    if (fds[1].revents & POLLIN) {
+        (void) !::read(mEventFd, &value, sizeof(value));
+    }
+
+    locker.lock();
+}
+
+void GTimerFdWaiter::notify()
+{
+    const uint64_t value = 1;
+    (void) !::write(mEventFd, &value, sizeof(value));
+}
+
+#endif
@@ -0,0 +1,85 @@
+//
+// Created by Gxin on 2024/3/23.
+//
+
+#ifndef GX_GTIMER_WAITER_H
+#define GX_GTIMER_WAITER_H
+
+#include "gx/gtimer.h"
+
+#include <condition_variable>
+
+
+/**
+ * @brief Blocks the scheduler thread until a deadline or until new tasks arrive.
+ * wait() is called with the scheduler lock held and may return early (spurious wakeup),
+ * notify() is called with the scheduler lock held.
+ */
+class GTimerWaiter
+{
+public:
+    virtual ~GTimerWaiter() = default;
+
+    /**
+     * @param locker    Scheduler lock, released while blocking
+     * @param deadline  Steady time in nanoseconds, GTimerQueue::NO_DEADLINE to wait for notify only
+     */
+    virtual void wait(GLocker<GMutex> &locker, int64_t deadline) = 0;
+
+    virtual void notify() = 0;
+
+    static std::unique_ptr<GTimerWaiter> create(GTimerScheduler::WaitMode mode, int64_t spinTime);
+};
+
+
+/**
+ * @brief std::condition_variable with an absolute steady clock deadline
+ */
+class GTimerCondWaiter : public GTimerWaiter
+{
+public:
+    explicit GTimerCondWaiter(int64_t spinTime);
+
+    void wait(GLocker<GMutex> &locker, int64_t deadline) override;
+
+    void notify() override;
+
+protected:
+    /**
+     * @brief Busy wait the last part before the deadline, the kernel wakeup latency is usually tens of microseconds
+     */
+    void spinUntil(GLocker<GMutex> &locker, int64_t deadline) const;
+
+protected:
+    const int64_t mSpinTime;
+    GConditionVariable mCond;
+};
+
+
+#if GX_PLATFORM_LINUX
+
+/**
+ * @brief timerfd (CLOCK_MONOTONIC, absolute) + eventfd multiplexed with poll().
+ * timerfd expirations are not subject to the timer slack applied to poll/nanosleep timeouts.
+ */
+class GTimerFdWaiter final : public GTimerCondWaiter
+{
+public:
+    explicit GTimerFdWaiter(int64_t spinTime);
+
+    ~GTimerFdWaiter() override;
+
+    bool isValid() const;
+
+    void wait(GLocker<GMutex> &locker, int64_t deadline) override;
+
+    void notify() override;
+
+private:
+    int mTimerFd = -1;
+    int mEventFd = -1;
+};
+
+#endif
+
+#endif //GX_GTIMER_WAITER_H
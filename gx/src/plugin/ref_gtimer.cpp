@@ -15,7 +15,12 @@ void refGTimer()
             .func("cancel", &GTimerTask::cancel);
 
     Class<GTimerScheduler>("Gx", "GTimerScheduler", "Gx timer scheduler.")
-            .staticFunc("create", &GTimerScheduler::create)
+            .staticFunc("create", [](std::string name) {
+                return GTimerScheduler::create(std::move(name));
+            }, {"", {"name"}})
+            .staticFunc("create", [](std::string name, int32_t backend) {
+                return GTimerScheduler::create(std::move(name), static_cast<GTimerScheduler::Backend>(backend));
+            }, {"Create a scheduler, backend: 0: Heap, 1: Wheel.", {"name", "backend"}})
             .staticFunc("makeGlobal", &GTimerScheduler::makeGlobal)
             .staticFunc("global", &GTimerScheduler::global)
             .func("run", &GTimerScheduler::run)
@@ -23,7 +28,25 @@ void refGTimer()
             .func("start", &GTimerScheduler::start)
             .func("stop", &GTimerScheduler::stop)
             .func("isRunning", &GTimerScheduler::isRunning)
-            .func("post", &GTimerScheduler::post);
+            .func("post", &GTimerScheduler::post, {"Post a one-time task, delay in milliseconds.", {"event", "delay"}})
+            .func("postMicroSecs", &GTimerScheduler::postMicroSecs, {"", {"event", "delay"}})
+            .func("postNanoSecs", &GTimerScheduler::postNanoSecs, {"", {"event", "delay"}})
+            .func("backend", [](const GTimerScheduler &self) {
+                return static_cast<int32_t>(self.backend());
+            })
+            .func("taskCount", &GTimerScheduler::taskCount)
+            .func("deadTaskCount", &GTimerScheduler::deadTaskCount)
+            .func("wakeupStats", [](const GTimerScheduler &self) {
+                const auto stats = self.wakeupStats();
+                auto obj = GAny::object();
+                obj["wakeups"] = stats.wakeups;
+                obj["firedTasks"] = stats.firedTasks;
+                obj["seconds"] = stats.seconds;
+                obj["wakeupsPerSecond"] = stats.wakeupsPerSecond();
+                obj["tasksPerWakeup"] = stats.tasksPerWakeup();
+                return obj;
+            })
+            .func("resetWakeupStats", &GTimerScheduler::resetWakeupStats);
 
     Class<GTimer>("Gx", "GTimer", "Gx timer.")
             .construct<>()
@@ -32,17 +55,39 @@ void refGTimer()
             .construct<bool>()
             .inherit<GObject>()
             .func("timerEvent", &GTimer::timerEvent)
+            .func("timerTickEvent", &GTimer::timerTickEvent, {"Event receiving the missed tick count.", {"event"}})
             .func("setOneShot", [](GTimer &self, bool oneShot) {
                 self.setOneShot(oneShot);
             })
             .func("setOneShot", [](GTimer &self) {
                 self.setOneShot();
             })
+            .func("setSchedule", [](GTimer &self, int32_t schedule) {
+                self.setSchedule(static_cast<GTimerSchedule>(schedule));
+            }, {"0: FixedDelay, 1: FixedRate.", {"schedule"}})
+            .func("setMissedTickPolicy", [](GTimer &self, int32_t policy) {
+                self.setMissedTickPolicy(static_cast<GTimerMissedTickPolicy>(policy));
+            }, {"0: FireAll, 1: Coalesce, 2: Skip.", {"policy"}})
+            .func("setSlack", &GTimer::setSlack, {"Slack in milliseconds.", {"slack"}})
+            .func("setSlackMicroSecs", &GTimer::setSlackMicroSecs, {"", {"slack"}})
+            .func("setSlackNanoSecs", &GTimer::setSlackNanoSecs, {"", {"slack"}})
             .func("start", [](GTimer &self, int64_t interval) {
                 self.start(interval);
             }, {"", {"interval"}})
             .func("start", [](GTimer &self, int64_t delay, int64_t interval) {
                 self.start(delay, interval);
             }, {"", {"delay", "interval"}})
+            .func("startMicroSecs", [](GTimer &self, int64_t interval) {
+                self.startMicroSecs(interval);
+            }, {"", {"interval"}})
+            .func("startMicroSecs", [](GTimer &self, int64_t delay, int64_t interval) {
+                self.startMicroSecs(delay, interval);
+            }, {"", {"delay", "interval"}})
+            .func("startNanoSecs", [](GTimer &self, int64_t interval) {
+                self.startNanoSecs(interval);
+            }, {"", {"interval"}})
+            .func("startNanoSecs", [](GTimer &self, int64_t delay, int64_t interval) {
+                self.startNanoSecs(delay, interval);
+            }, {"", {"delay", "interval"}})
             .func("stop", &GTimer::stop);
 }
@@ -11,6 +11,28 @@
 
 using namespace gany;
 
+static GAny histogramToGAny(const GHistogram::Snapshot &snapshot)
+{
+    GAny obj = GAny::object();
+    obj["count"] = snapshot.count;
+    obj["min"] = snapshot.min;
+    obj["max"] = snapshot.max;
+    obj["mean"] = snapshot.mean();
+    obj["p50"] = snapshot.percentile(50);
+    obj["p90"] = snapshot.percentile(90);
+    obj["p99"] = snapshot.percentile(99);
+    obj["p999"] = snapshot.percentile(99.9);
+    return obj;
+}
+
+static GAny taskStatsToGAny(const GTaskSystem::TaskStats &stats)
+{
+    GAny obj = GAny::object();
+    obj["waitTime"] = histogramToGAny(stats.waitTime);
+    obj["execTime"] = histogramToGAny(stats.execTime);
+    return obj;
+}
+
 void refTaskSystem()
 {
     Class<GTaskSystem>("Gx", "GTaskSystem",
@@ -94,7 +116,38 @@ void refTaskSystem()
                       "Task"
                   })
             .func("waitingTaskCount", &GTaskSystem::waitingTaskCount,
-                  {"Get the count of tasks waiting."});
+                  {"Get the count of tasks waiting."})
+            .func("setStatsEnabled", &GTaskSystem::setStatsEnabled,
+                  {"Enable or disable recording of task wait/exec time.", {"enabled"}})
+            .func("isStatsEnabled", &GTaskSystem::isStatsEnabled,
+                  {"Whether task wait/exec time is recorded."})
+            .func("taskStats",
+                  [](const GTaskSystem &self) {
+                      return taskStatsToGAny(self.taskStats());
+                  },
+                  {
+                      "Get the wait/exec time statistics (nanoseconds) of all tasks, "
+                      "{waitTime: {count, min, max, mean, p50, p90, p99, p999}, execTime: {...}}."
+                  })
+            .func("taskStats",
+                  [](const GTaskSystem &self, int32_t priority) {
+                      if (priority < 0 || priority >= (int32_t) GTaskSystem::TASK_PRIORITY_COUNT) {
+                          return GAny::undefined();
+                      }
+                      return taskStatsToGAny(self.taskStats(static_cast<GTaskSystem::TaskPriority>(priority)));
+                  },
+                  {
+                      "Get the wait/exec time statistics of the specified priority class, "
+                      "0: tasks from submit, 1: tasks from submitFront.",
+                      {"priority"}
+                  })
+            .func("takeTaskStats",
+                  [](GTaskSystem &self) {
+                      return taskStatsToGAny(self.takeTaskStats());
+                  },
+                  {"Get the statistics of all tasks and reset them."})
+            .func("resetTaskStats", &GTaskSystem::resetTaskStats,
+                  {"Reset the task statistics."});
 
     Class<GTaskSystem::Task<GAny> >("Gx", "Task", "Task results of TaskSystem.")
             .func("get",